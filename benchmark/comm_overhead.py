@@ -0,0 +1,122 @@
+""" Measure the per-step cost of communication between chunks.
+
+Builds a network of many small 1-D ensembles arranged in streams, with
+consecutive ensembles of each stream placed on different processes, so that
+nearly every connection becomes a small message between chunks and the
+neural computation per step is negligible. The network is saved to a file
+and then run under nengo_mpi with each of the variants, e.g.
+
+    python comm_overhead.py -p 2 --ns 20 --sl 4
+
+compares persistent and non-persistent requests, the one-sided (rma)
+transport with and without message aggregation, and the neighborhood
+collective (neighbor) transport. Variants take the same
+form as in compare_options.py.
+
+"""
+from __future__ import print_function
+import os
+import argparse
+from collections import OrderedDict
+
+import numpy as np
+
+import nengo
+import nengo_mpi
+
+from compare_options import run_variant, parse_variants
+
+DEFAULT_VARIANTS = [
+    'persistent:--noaggregate',
+    'nonpersistent:--noaggregate,--nopersistent',
+    'aggregated:',
+    'aggregated-nonpersistent:--nopersistent',
+    'rma:--noaggregate,--transport=rma',
+    'aggregated-rma:--transport=rma',
+    'neighbor:--transport=neighbor']
+
+
+def build_network(n_streams, stream_length, n_neurons, n_procs, seed):
+    assignments = {}
+
+    m = nengo.Network(label='CommOverhead', seed=seed)
+    with m:
+        m.config[nengo.Ensemble].neuron_type = nengo.LIF()
+        input_node = nengo.Node(output=[0.25])
+
+        for i in range(n_streams):
+            prev = input_node
+            for j in range(stream_length):
+                ensemble = nengo.Ensemble(
+                    n_neurons, dimensions=1,
+                    label="stream %d, index %d" % (i, j))
+                nengo.Connection(prev, ensemble)
+
+                assignments[ensemble] = (i + j) % n_procs
+                prev = ensemble
+
+    return m, assignments
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Compare per-step communication overhead of "
+                    "nengo_mpi options on a network of many small messages.")
+
+    parser.add_argument(
+        'variants', nargs='*', default=DEFAULT_VARIANTS,
+        help='Variants to compare, each of the form name:options. '
+             'Separate multiple options within a variant by commas.')
+    parser.add_argument(
+        '-p', type=int, default=2, help='Number of processes.')
+    parser.add_argument(
+        '--ns', type=int, default=20, help='Number of streams.')
+    parser.add_argument(
+        '--sl', type=int, default=4, help='Length of each stream.')
+    parser.add_argument(
+        '--npe', type=int, default=5,
+        help='Number of neurons in each ensemble.')
+    parser.add_argument(
+        '-t', type=float, default=5.0, help='Length of each simulation.')
+    parser.add_argument(
+        '--rounds', type=int, default=3, help='Number of runs per variant.')
+    parser.add_argument(
+        '--save', type=str, default='comm_overhead.net',
+        help='File to write the network to.')
+    parser.add_argument(
+        '--bin', type=str, default=os.path.join(
+            os.path.dirname(os.path.abspath(__file__)), '..', 'bin'),
+        help='Directory containing the nengo_mpi executable.')
+    parser.add_argument(
+        '--seed', type=int, default=None,
+        help="Seed for random number generation.")
+    parser.add_argument('-v', action='store_true', help='Verbose.')
+
+    args = parser.parse_args()
+    assert args.p > 1, "Need at least 2 processes to communicate."
+
+    m, assignments = build_network(
+        args.ns, args.sl, args.npe, args.p, args.seed)
+    nengo_mpi.Simulator(
+        m, dt=0.001, assignments=assignments, save_file=args.save)
+
+    n_messages = args.ns * args.sl
+    print("Saved network with about %d connections between chunks to %s" % (
+        n_messages, args.save))
+
+    variants = parse_variants(args.variants)
+    results = OrderedDict((name, []) for name in variants)
+
+    for r in range(args.rounds):
+        for name, options in variants.items():
+            per_step = run_variant(
+                args.bin, args.p, options, args.save, args.t, args.v)
+            results[name].append(per_step)
+
+    baseline = None
+    print("%-25s %15s %15s %10s" % ('variant', 'mean (s/step)', 'std', 'speedup'))
+    for name, times in results.items():
+        mean = np.mean(times)
+        baseline = baseline or mean
+        print("%-25s %15.3e %15.3e %10.2f" % (
+            name, mean, np.std(times), baseline / mean))
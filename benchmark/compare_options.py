@@ -0,0 +1,106 @@
+""" Compare per-step simulation time of a network file under different
+sets of options to the nengo_cpp/nengo_mpi executables.
+
+Each variant is given as name:options, e.g.
+
+    python compare_options.py net.net -t 1.0 plan: virtual:--noplan
+
+runs ``nengo_cpp net.net 1.0`` and ``nengo_cpp --noplan net.net 1.0``,
+``--rounds`` times each, and prints the mean and standard deviation of the
+time taken per step for each variant. Supplying ``-p`` with a value greater
+than 1 runs nengo_mpi under mpirun instead.
+
+"""
+from __future__ import print_function
+import os
+import re
+import subprocess
+import argparse
+from collections import OrderedDict
+
+import numpy as np
+
+SIM_PATTERN = 'Simulating (\d+) steps took (\d+\.\d+)'
+
+DEFAULT_VARIANTS = ['plan:', 'virtual:--noplan']
+
+
+def extract_per_step(text):
+    """ Extract seconds-per-step from the output of nengo_cpp/nengo_mpi. """
+
+    matches = re.findall(SIM_PATTERN, text)
+    if len(matches) != 1:
+        raise Exception('No simulation timing information in output.')
+
+    n_steps, seconds = matches[0]
+    return float(seconds) / int(n_steps)
+
+
+def run_variant(bin_dir, n_procs, options, network, t, verbose):
+    if n_procs > 1:
+        command = ['mpirun', '-np', str(n_procs),
+                   os.path.join(bin_dir, 'nengo_mpi')]
+    else:
+        command = [os.path.join(bin_dir, 'nengo_cpp')]
+
+    command += ['--noprog'] + options.split() + [network, str(t)]
+
+    if verbose:
+        print(' '.join(command))
+
+    output = subprocess.check_output(command, stderr=subprocess.STDOUT)
+    output = output.decode() if hasattr(output, 'decode') else output
+
+    if verbose:
+        print(output)
+
+    return extract_per_step(output)
+
+
+def parse_variants(variants):
+    parsed = OrderedDict()
+    for v in variants:
+        name, _, options = v.partition(':')
+        parsed[name] = options.replace(',', ' ')
+    return parsed
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Compare per-step runtimes of executable options.")
+
+    parser.add_argument('network', type=str, help='The .net file to run.')
+    parser.add_argument(
+        'variants', nargs='*', default=DEFAULT_VARIANTS,
+        help='Variants to compare, each of the form name:options. '
+             'Separate multiple options within a variant by commas.')
+    parser.add_argument(
+        '-t', type=float, default=1.0, help='Length of each simulation.')
+    parser.add_argument(
+        '-p', type=int, default=1, help='Number of processes.')
+    parser.add_argument(
+        '--rounds', type=int, default=3, help='Number of runs per variant.')
+    parser.add_argument(
+        '--bin', type=str, default=os.path.join(
+            os.path.dirname(os.path.abspath(__file__)), '..', 'bin'),
+        help='Directory containing the nengo_cpp and nengo_mpi executables.')
+    parser.add_argument('-v', action='store_true', help='Verbose.')
+
+    args = parser.parse_args()
+
+    variants = parse_variants(args.variants)
+    results = OrderedDict((name, []) for name in variants)
+
+    for r in range(args.rounds):
+        for name, options in variants.items():
+            per_step = run_variant(
+                args.bin, args.p, options, args.network, args.t, args.v)
+            results[name].append(per_step)
+
+    baseline = None
+    print("%-20s %15s %15s %10s" % ('variant', 'mean (s/step)', 'std', 'speedup'))
+    for name, times in results.items():
+        mean = np.mean(times)
+        baseline = baseline or mean
+        print("%-20s %15.3e %15.3e %10.2f" % (
+            name, mean, np.std(times), baseline / mean))
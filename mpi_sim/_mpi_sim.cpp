@@ -29,7 +29,7 @@ extern "C" PyObject* mpi_sim_get_n_procs(PyObject *self, PyObject *args);
 extern "C" PyObject* mpi_sim_kill_workers(PyObject *self, PyObject *args);
 extern "C" PyObject* mpi_sim_worker_start(PyObject *self, PyObject *args);
 
-extern "C" PyObject* mpi_sim_create_simulator(PyObject *self, PyObject *args);
+extern "C" PyObject* mpi_sim_create_simulator(PyObject *self, PyObject *args, PyObject *kwargs);
 extern "C" PyObject* mpi_sim_load_network(PyObject *self, PyObject *args);
 extern "C" PyObject* mpi_sim_finalize_build(PyObject *self, PyObject *args);
 
@@ -48,7 +48,8 @@ static PyMethodDef module_functions[] = {
     {"kill_workers", mpi_sim_kill_workers, METH_VARARGS, kill_workers_docstring},
     {"worker_start", mpi_sim_worker_start, METH_VARARGS, worker_start_docstring},
 
-    {"create_simulator", mpi_sim_create_simulator, METH_VARARGS, create_simulator_docstring},
+    {"create_simulator", (PyCFunction)mpi_sim_create_simulator,
+     METH_VARARGS | METH_KEYWORDS, create_simulator_docstring},
     {"load_network", mpi_sim_load_network, METH_VARARGS, load_network_docstring},
     {"finalize_build", mpi_sim_finalize_build, METH_VARARGS, finalize_build_docstring},
 
@@ -90,16 +91,20 @@ MOD_INIT(mpi_sim)
     /* Load `numpy` functionality. */
     import_array();
 
+    /* Name of the numpy type matching dtype, for buffers shared with C++. */
+    PyModule_AddStringConstant(m, "dtype", DTYPE_NAME);
+
     return MOD_SUCCESS_VAL(m);
 }
 
 extern "C" PyObject *mpi_sim_init(PyObject *self, PyObject *args){
 
-    if(!PyArg_ParseTuple(args, "")){
+    int thread_multiple = 0;
+    if(!PyArg_ParseTuple(args, "|i", &thread_multiple)){
         return NULL;
     }
 
-    mpi_init();
+    mpi_init(bool(thread_multiple));
 
     Py_INCREF(Py_None);
     return Py_None;
@@ -158,15 +163,57 @@ extern "C" PyObject *mpi_sim_worker_start(PyObject *self, PyObject *args){
 
 unique_ptr<Simulator> simulator;
 
-extern "C" PyObject *mpi_sim_create_simulator(PyObject *self, PyObject *args){
-    if(!PyArg_ParseTuple(args, "")){
+// The options for communication between chunks may be given by keyword
+// (see SimulatorConfig); everything else keeps its default.
+extern "C" PyObject *mpi_sim_create_simulator(PyObject *self, PyObject *args, PyObject *kwargs){
+    SimulatorConfig config;
+
+    const char *transport = NULL;
+    int aggregate_messages = config.aggregate_messages;
+    int persistent_requests = config.persistent_requests;
+    unsigned zero_copy_size = config.zero_copy_size;
+    unsigned n_threads = config.n_threads;
+    int hybrid = config.hybrid;
+    int use_plan = config.use_plan;
+    int autotune = config.autotune;
+
+    static const char *keywords[] = {
+        "transport", "aggregate_messages", "persistent_requests", "zero_copy_size",
+        "use_plan", "n_threads", "hybrid", "autotune", NULL};
+
+    if(!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|ziiIiIii", const_cast<char**>(keywords), &transport,
+            &aggregate_messages, &persistent_requests, &zero_copy_size, &use_plan,
+            &n_threads, &hybrid, &autotune)){
         return NULL;
     }
 
+    if(n_threads == 0){
+        PyErr_SetString(PyExc_ValueError, "n_threads must be at least 1.");
+        return NULL;
+    }
+
+    if(transport){
+        try{
+            config.transport = transport_from_string(transport);
+        }catch(runtime_error& e){
+            PyErr_SetString(PyExc_ValueError, e.what());
+            return NULL;
+        }
+    }
+
+    config.aggregate_messages = aggregate_messages;
+    config.persistent_requests = persistent_requests;
+    config.zero_copy_size = zero_copy_size;
+    config.use_plan = use_plan;
+    config.n_threads = n_threads;
+    config.hybrid = hybrid;
+    config.autotune = autotune;
+
     if(n_processors_available == 1){
-        simulator = unique_ptr<Simulator>(new Simulator(false));
+        simulator = unique_ptr<Simulator>(new Simulator(false, config));
     }else{
-        simulator = unique_ptr<Simulator>(new MpiSimulator(false));
+        simulator = unique_ptr<Simulator>(new MpiSimulator(false, config));
     }
 
     Py_INCREF(Py_None);
@@ -203,7 +250,12 @@ extern "C" PyObject *mpi_sim_run_n_steps(PyObject *self, PyObject *args){
         return NULL;
     }
 
-    simulator->run_n_steps(n_steps, progress, log_filename);
+    try{
+        simulator->run_n_steps(n_steps, progress, log_filename);
+    }catch(const PythonException& e){
+        // A python function raised an error, which is still set.
+        return NULL;
+    }
 
     Py_INCREF(Py_None);
     return Py_None;
@@ -236,7 +288,7 @@ extern "C" PyObject *mpi_sim_get_probe_data(PyObject *self, PyObject *args){
             ndim = 2;
         }
 
-        array = PyArray_SimpleNew(ndim, shape, NPY_DOUBLE);
+        array = PyArray_SimpleNew(ndim, shape, NPY_DTYPE);
         if (array == NULL) return NULL; // TODO
         d.copy_to_buffer((dtype*)(PyArray_DATA((PyArrayObject*)(array))));
 
@@ -267,7 +319,7 @@ extern "C" PyObject *mpi_sim_get_signal_value(PyObject *self, PyObject *args){
         ndim = 2;
     }
 
-    array = PyArray_SimpleNew(ndim, shape, NPY_DOUBLE);
+    array = PyArray_SimpleNew(ndim, shape, NPY_DTYPE);
     if (array == NULL) return NULL; // TODO
     signal.copy_to_buffer((dtype*)(PyArray_DATA((PyArrayObject*)(array))));
 
@@ -336,6 +388,9 @@ extern "C" PyObject *mpi_sim_create_PyFunc(PyObject *self, PyObject *args){
     return Py_None;
 }
 
+// Stands for the state of the python interpreter; see PyFunc::get_accesses.
+Signal PyFunc::python_state(1, 0.0, "python_state");
+
 PyFunc::PyFunc(
     PyObject* fn, Signal time, Signal input, Signal output,
     dtype* time_buffer, dtype* input_buffer, dtype* output_buffer)
@@ -367,6 +422,20 @@ void PyFunc::operator() (){
     run_dbg(*this);
 }
 
+bool PyFunc::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(time, ACCESS_READ));
+    accesses.push_back(SignalAccess(input, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    // Python functions can have side effects that other python functions
+    // see (e.g. Nodes sharing an object), so every PyFunc updates the same
+    // signal. That keeps PyFuncs in list order relative to each other, while
+    // other operators can still be moved across them.
+    accesses.push_back(SignalAccess(python_state, ACCESS_UPDATE));
+
+    return true;
+}
+
 PyFunc::~PyFunc(){
     Py_XDECREF(fn);
 }
@@ -30,8 +30,14 @@ public:
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+    // Must run on the thread that holds the GIL.
+    bool requires_main_thread() const { return true; }
 
 private:
+    static Signal python_state;
+
     PyObject* fn;
 
     Signal time;
@@ -0,0 +1,28 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <sys/mman.h>
+
+shared_ptr<dtype> allocate_signal_arena(size_t size, bool huge_pages){
+    size_t n_bytes = max(size, size_t(1)) * sizeof(dtype);
+    size_t alignment = SIGNAL_ARENA_ALIGNMENT;
+
+    if(huge_pages){
+        alignment = HUGE_PAGE_SIZE;
+        n_bytes = (n_bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+
+    void* block = nullptr;
+    if(posix_memalign(&block, alignment, n_bytes) != 0){
+        throw bad_alloc();
+    }
+
+#ifdef MADV_HUGEPAGE
+    // Only a hint; if it fails, the arena just uses regular pages.
+    if(huge_pages){
+        madvise(block, n_bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    return shared_ptr<dtype>(static_cast<dtype*>(block), [](dtype* p){ free(p); });
+}
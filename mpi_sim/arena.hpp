@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <cstdlib>
+
+#include "typedef.hpp"
+
+using namespace std;
+
+// Alignment of the arena and of every base signal placed in it, in bytes.
+// One cache line, so that no two base signals share a line.
+const size_t SIGNAL_ARENA_ALIGNMENT = 64;
+
+// Size of the pages requested when the arena is backed by huge pages.
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/* Number of dtypes to reserve in an arena for a signal of ``size`` dtypes, so
+ * that the next signal placed after it stays aligned. */
+inline size_t arena_padded_size(size_t size){
+    const size_t per_line = SIGNAL_ARENA_ALIGNMENT / sizeof(dtype);
+    return (size + per_line - 1) / per_line * per_line;
+}
+
+/* Allocate a block of ``size`` dtypes, aligned to SIGNAL_ARENA_ALIGNMENT
+ * bytes, for holding the base signals of a chunk. With ``huge_pages``, the
+ * block is aligned to and padded to a multiple of HUGE_PAGE_SIZE, and the
+ * kernel is asked to back it with (transparent) huge pages where that is
+ * supported. The block is freed when the last pointer into it (including
+ * pointers made with shared_ptr's aliasing constructor) is destroyed. */
+shared_ptr<dtype> allocate_signal_arena(size_t size, bool huge_pages);
@@ -0,0 +1,308 @@
+#include "batched_operator.hpp"
+
+// Approximate size of the blocks of A that BatchedDotInc keeps in cache.
+#define BATCHED_DOT_INC_BLOCK_BYTES (256 * 1024)
+
+unique_ptr<Operator> make_batched_operator(const vector<Operator*>& members){
+    string classname = members[0]->classname();
+
+    if(classname.compare("LIF") == 0){
+        return unique_ptr<Operator>(new BatchedLIF(members));
+
+    }else if(classname.compare("AdaptiveLIF") == 0){
+        return unique_ptr<Operator>(new BatchedAdaptiveLIF(members));
+
+    }else if(classname.compare("SimpleSynapse") == 0){
+        return unique_ptr<Operator>(new BatchedSimpleSynapse(members));
+
+    }else if(classname.compare("Synapse") == 0){
+        return unique_ptr<Operator>(new BatchedSynapse(members));
+
+    }else if(classname.compare("NoDenSynapse") == 0){
+        return unique_ptr<Operator>(new BatchedNoDenSynapse(members));
+
+    }else if(classname.compare("DotInc") == 0){
+        return unique_ptr<Operator>(new BatchedDotInc(members));
+
+    }else{
+        stringstream msg;
+        msg << "Cannot create a batched operator for operators of type: " << classname;
+        throw runtime_error(msg.str());
+    }
+}
+
+// ********************************************************************************
+bool BatchedOperator::get_accesses(vector<SignalAccess>& accesses) const{
+    for(Operator* op: members){
+        op->get_accesses(accesses);
+    }
+
+    return true;
+}
+
+string BatchedOperator::to_string() const{
+    stringstream out;
+    out << Operator::to_string();
+    out << "n_members: " << members.size() << endl;
+    out << "n_segments: " << n_segments() << endl;
+    out << "first member:" << endl;
+    out << *members[0] << endl;
+
+    return out.str();
+}
+
+// ********************************************************************************
+BatchedLIF::BatchedLIF(const vector<Operator*>& members)
+:BatchedOperator(members), params(static_cast<LIF*>(members[0])->params){
+
+    for(Operator* op: members){
+        LIF* lif = static_cast<LIF*>(op);
+
+        BatchSegment<4> seg = {
+            {lif->J.data, lif->output.data,
+             lif->voltage.data, lif->ref_time.data},
+            {lif->J.stride1, lif->output.stride1,
+             lif->voltage.stride1, lif->ref_time.stride1},
+            lif->n_neurons};
+
+        append_segment(segments, seg);
+
+        if(lif->spikes){
+            spiking.push_back(lif);
+        }
+    }
+}
+
+void BatchedLIF::operator() (){
+    for(auto& seg: segments){
+        lif_kernel(
+            params, seg.n, seg.ptr[0], seg.stride[0], seg.ptr[1], seg.stride[1],
+            seg.ptr[2], seg.stride[2], seg.ptr[3], seg.stride[3]);
+    }
+
+    for(LIF* lif: spiking){
+        lif->record_spikes();
+    }
+
+    run_dbg(*this);
+}
+
+void BatchedLIF::reset(unsigned seed){
+    for(LIF* lif: spiking){
+        lif->reset(seed);
+    }
+}
+
+// ********************************************************************************
+BatchedAdaptiveLIF::BatchedAdaptiveLIF(const vector<Operator*>& members)
+:BatchedOperator(members),
+params(static_cast<AdaptiveLIF*>(members[0])->params),
+adapt_params(static_cast<AdaptiveLIF*>(members[0])->adapt_params){
+
+    for(Operator* op: members){
+        AdaptiveLIF* alif = static_cast<AdaptiveLIF*>(op);
+
+        BatchSegment<5> seg = {
+            {alif->J.data, alif->output.data, alif->voltage.data,
+             alif->ref_time.data, alif->adaptation.data},
+            {alif->J.stride1, alif->output.stride1, alif->voltage.stride1,
+             alif->ref_time.stride1, alif->adaptation.stride1},
+            alif->n_neurons};
+
+        append_segment(segments, seg);
+
+        if(alif->spikes){
+            spiking.push_back(alif);
+        }
+    }
+}
+
+void BatchedAdaptiveLIF::operator() (){
+    for(auto& seg: segments){
+        adaptive_lif_kernel(
+            params, adapt_params, seg.n, seg.ptr[0], seg.stride[0],
+            seg.ptr[1], seg.stride[1], seg.ptr[2], seg.stride[2],
+            seg.ptr[3], seg.stride[3], seg.ptr[4], seg.stride[4]);
+    }
+
+    for(LIF* lif: spiking){
+        lif->record_spikes();
+    }
+
+    run_dbg(*this);
+}
+
+void BatchedAdaptiveLIF::reset(unsigned seed){
+    for(LIF* lif: spiking){
+        lif->reset(seed);
+    }
+}
+
+// ********************************************************************************
+BatchedSimpleSynapse::BatchedSimpleSynapse(const vector<Operator*>& members)
+:BatchedOperator(members),
+a(static_cast<SimpleSynapse*>(members[0])->a),
+b(static_cast<SimpleSynapse*>(members[0])->b){
+
+    for(Operator* op: members){
+        SimpleSynapse* syn = static_cast<SimpleSynapse*>(op);
+
+        BatchSegment<2> seg = {
+            {syn->input.data, syn->output.data}, {0, 0}, syn->output.size()};
+
+        flat_stride(syn->input, seg.stride[0]);
+        flat_stride(syn->output, seg.stride[1]);
+
+        append_segment(segments, seg);
+    }
+}
+
+void BatchedSimpleSynapse::operator() (){
+    for(auto& seg: segments){
+        const dtype* input = seg.ptr[0];
+        dtype* output = seg.ptr[1];
+
+        for(unsigned i = 0; i < seg.n; ++i){
+            dtype& out = output[int(i) * seg.stride[1]];
+            out *= -a;
+            out += b * input[int(i) * seg.stride[0]];
+        }
+    }
+
+    run_dbg(*this);
+}
+
+// ********************************************************************************
+unsigned BatchedSynapse::total_size(const vector<Operator*>& members){
+    unsigned n = 0;
+    for(Operator* op: members){
+        n += static_cast<Synapse*>(op)->output.size();
+    }
+
+    return n;
+}
+
+BatchedSynapse::BatchedSynapse(const vector<Operator*>& members)
+:BatchedOperator(members),
+history(
+    total_size(members), static_cast<Synapse*>(members[0])->numer,
+    static_cast<Synapse*>(members[0])->denom){
+
+    for(Operator* op: members){
+        Synapse* syn = static_cast<Synapse*>(op);
+
+        BatchSegment<2> seg = {
+            {syn->input.data, syn->output.data}, {0, 0}, syn->output.size()};
+
+        flat_stride(syn->input, seg.stride[0]);
+        flat_stride(syn->output, seg.stride[1]);
+
+        append_segment(segments, seg);
+    }
+}
+
+void BatchedSynapse::operator() (){
+    dtype* y = scratch_space(history.size());
+    dtype* x = history.push_input(y);
+    for(auto& seg: segments){
+        const dtype* input = seg.ptr[0];
+
+        for(unsigned i = 0; i < seg.n; ++i){
+            x[i] = input[int(i) * seg.stride[0]];
+        }
+
+        x += seg.n;
+    }
+
+    history.step(y);
+    for(auto& seg: segments){
+        dtype* output = seg.ptr[1];
+
+        for(unsigned i = 0; i < seg.n; ++i){
+            output[int(i) * seg.stride[1]] = y[i];
+        }
+
+        y += seg.n;
+    }
+
+    run_dbg(*this);
+}
+
+void BatchedSynapse::reset(unsigned seed){
+    history.reset();
+}
+
+// ********************************************************************************
+BatchedNoDenSynapse::BatchedNoDenSynapse(const vector<Operator*>& members)
+:BatchedOperator(members),
+b(static_cast<NoDenSynapse*>(members[0])->b){
+
+    for(Operator* op: members){
+        NoDenSynapse* syn = static_cast<NoDenSynapse*>(op);
+
+        BatchSegment<2> seg = {
+            {syn->input.data, syn->output.data}, {0, 0}, syn->output.size()};
+
+        flat_stride(syn->input, seg.stride[0]);
+        flat_stride(syn->output, seg.stride[1]);
+
+        append_segment(segments, seg);
+    }
+}
+
+void BatchedNoDenSynapse::operator() (){
+    for(auto& seg: segments){
+        const dtype* input = seg.ptr[0];
+        dtype* output = seg.ptr[1];
+
+        for(unsigned i = 0; i < seg.n; ++i){
+            output[int(i) * seg.stride[1]] = b * input[int(i) * seg.stride[0]];
+        }
+    }
+
+    run_dbg(*this);
+}
+
+// ********************************************************************************
+BatchedDotInc::BatchedDotInc(const vector<Operator*>& members)
+:BatchedOperator(members), A(static_cast<DotInc*>(members[0])->A),
+leading_dim_A(static_cast<DotInc*>(members[0])->leading_dim_A){
+
+    for(Operator* op: members){
+        DotInc* dot_inc = static_cast<DotInc*>(op);
+        X.push_back(dot_inc->X);
+        Y.push_back(dot_inc->Y);
+    }
+
+    rows_per_block = max(1u, unsigned(BATCHED_DOT_INC_BLOCK_BYTES / (sizeof(dtype) * A.shape2)));
+
+    DotInc* first = static_cast<DotInc*>(members[0]);
+    small_kernel = rows_per_block >= A.shape1 ? first->small_kernel : nullptr;
+}
+
+void BatchedDotInc::operator() (){
+    if(small_kernel){
+        for(unsigned k = 0; k < X.size(); k++){
+            small_kernel(
+                A.data, leading_dim_A, A.shape1, A.shape2,
+                X[k].data, X[k].stride1, Y[k].data, Y[k].stride1);
+        }
+
+        run_dbg(*this);
+        return;
+    }
+
+    for(unsigned start = 0; start < A.shape1; start += rows_per_block){
+        unsigned n_block_rows = min(rows_per_block, A.shape1 - start);
+        const dtype* A_block = A.data + int(start) * leading_dim_A;
+
+        for(unsigned k = 0; k < X.size(); k++){
+            cblas_xgemv(
+                CblasRowMajor, CblasNoTrans, n_block_rows, A.shape2, 1.0,
+                A_block, leading_dim_A, X[k].data, X[k].stride1,
+                1.0, Y[k].data + int(start) * Y[k].stride1, Y[k].stride1);
+        }
+    }
+
+    run_dbg(*this);
+}
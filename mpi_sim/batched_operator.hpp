@@ -0,0 +1,202 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <cmath>
+
+#include "signal.hpp"
+#include "operator.hpp"
+#include "neuron_kernels.hpp"
+
+#include "typedef.hpp"
+#include "debug.hpp"
+
+using namespace std;
+
+// Batched operators run a group of independent operators of the same type
+// (as identified by Operator::merge_key) as a single operator. The members
+// are kept around (they are still owned by the chunk) so that we can report
+// on them, but they are no longer called directly.
+//
+// Each batched operator stores its data as a list of segments. Segments whose
+// arrays directly follow those of the previous segment in memory are
+// coalesced, so members whose signals happen to be laid out contiguously
+// are processed as one long loop. The signal arena (see arena.hpp) puts
+// each member's signals next to each other, not each role's signals
+// across members, so usually only members that share base signals are
+// coalesced. Otherwise each member stays a segment of its own, and
+// batching only saves the per-operator dispatch.
+
+/* A run of ``n`` elements, where element i of the k-th array
+ * is at ptr[k][i * stride[k]]. */
+template<int N>
+struct BatchSegment{
+    dtype* ptr[N];
+    int stride[N];
+    unsigned n;
+};
+
+template<int N>
+void append_segment(vector<BatchSegment<N>>& segments, const BatchSegment<N>& seg){
+    if(segments.size() > 0){
+        BatchSegment<N>& last = segments.back();
+
+        bool continues = true;
+        for(int k = 0; k < N; k++){
+            continues &= last.stride[k] == 1 && seg.stride[k] == 1;
+            continues &= last.ptr[k] + last.n == seg.ptr[k];
+        }
+
+        if(continues){
+            last.n += seg.n;
+            return;
+        }
+    }
+
+    segments.push_back(seg);
+}
+
+/* Create a batched operator from operators that all returned the same merge_key. */
+unique_ptr<Operator> make_batched_operator(const vector<Operator*>& members);
+
+class BatchedOperator: public Operator{
+public:
+    BatchedOperator(const vector<Operator*>& members):members(members){}
+
+    virtual string classname() const { return "BatchedOperator"; }
+
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+    virtual string to_string() const;
+
+protected:
+    virtual unsigned n_segments() const = 0;
+
+    vector<Operator*> members;
+};
+
+class BatchedLIF: public BatchedOperator{
+public:
+    BatchedLIF(const vector<Operator*>& members);
+    virtual string classname() const { return "BatchedLIF"; }
+
+    void operator()();
+    virtual void reset(unsigned seed);
+
+protected:
+    unsigned n_segments() const { return segments.size(); }
+
+    const LIFParams params;
+
+    // Arrays are J, output, voltage, ref_time.
+    vector<BatchSegment<4>> segments;
+
+    // Members that record their spikes (see LIF::get_spike_list).
+    vector<LIF*> spiking;
+};
+
+class BatchedAdaptiveLIF: public BatchedOperator{
+public:
+    BatchedAdaptiveLIF(const vector<Operator*>& members);
+    virtual string classname() const { return "BatchedAdaptiveLIF"; }
+
+    void operator()();
+    virtual void reset(unsigned seed);
+
+protected:
+    unsigned n_segments() const { return segments.size(); }
+
+    const LIFParams params;
+    const AdaptationParams adapt_params;
+
+    // Arrays are J, output, voltage, ref_time, adaptation.
+    vector<BatchSegment<5>> segments;
+
+    // Members that record their spikes (see LIF::get_spike_list).
+    vector<LIF*> spiking;
+};
+
+class BatchedSimpleSynapse: public BatchedOperator{
+public:
+    BatchedSimpleSynapse(const vector<Operator*>& members);
+    virtual string classname() const { return "BatchedSimpleSynapse"; }
+
+    void operator()();
+
+protected:
+    unsigned n_segments() const { return segments.size(); }
+
+    const dtype a;
+    const dtype b;
+
+    // Arrays are input, output.
+    vector<BatchSegment<2>> segments;
+};
+
+class BatchedSynapse: public BatchedOperator{
+public:
+    BatchedSynapse(const vector<Operator*>& members);
+    virtual string classname() const { return "BatchedSynapse"; }
+
+    void operator()();
+    virtual void reset(unsigned seed);
+    size_t scratch_size() const { return history.size(); }
+
+protected:
+    unsigned n_segments() const { return segments.size(); }
+
+    // Total number of elements filtered by ``members``.
+    static unsigned total_size(const vector<Operator*>& members);
+
+    // Arrays are input, output.
+    vector<BatchSegment<2>> segments;
+
+    // History of all members' elements, in segment order.
+    FilterHistory history;
+};
+
+class BatchedNoDenSynapse: public BatchedOperator{
+public:
+    BatchedNoDenSynapse(const vector<Operator*>& members);
+    virtual string classname() const { return "BatchedNoDenSynapse"; }
+
+    void operator()();
+
+protected:
+    unsigned n_segments() const { return segments.size(); }
+
+    const dtype b;
+
+    // Arrays are input, output.
+    vector<BatchSegment<2>> segments;
+};
+
+/* Matrix-vector DotIncs that share a row-major A. A is processed in blocks
+ * of rows that fit in cache, and each block is multiplied by every member's X
+ * before moving on to the next, so A is read from memory once per step
+ * instead of once per member. Each block is still multiplied by a gemv, so
+ * results usually match the members' exactly (but depending on the BLAS
+ * implementation, may differ in the last bits). */
+class BatchedDotInc: public BatchedOperator{
+public:
+    BatchedDotInc(const vector<Operator*>& members);
+    virtual string classname() const { return "BatchedDotInc"; }
+
+    void operator()();
+
+protected:
+    unsigned n_segments() const { return 1; }
+
+    SignalView A;
+    unsigned leading_dim_A;
+
+    vector<SignalView> X;
+    vector<SignalView> Y;
+
+    // Number of rows of A in each block.
+    unsigned rows_per_block;
+
+    // The members' small-matrix kernel, if A fits in a single block.
+    SmallGemvKernel small_kernel;
+};
@@ -3,13 +3,16 @@
 // in bytes, for each process.
 #define MAX_RUNTIME_OUTPUT_SIZE 5000
 
-MpiSimulatorChunk::MpiSimulatorChunk(bool collect_timings)
-:dt(0.001), rank(0), n_processors(1), collect_timings(collect_timings){
+MpiSimulatorChunk::MpiSimulatorChunk(bool collect_timings, SimulatorConfig config)
+:dt(0.001), rank(0), n_processors(1), arena_size(0), arena_used(0),
+arena_open(false), collect_timings(collect_timings), config(config){
 
 }
 
-MpiSimulatorChunk::MpiSimulatorChunk(int rank, int n_processors, bool collect_timings)
-:dt(0.001), rank(rank), n_processors(n_processors), collect_timings(collect_timings){
+MpiSimulatorChunk::MpiSimulatorChunk(
+    int rank, int n_processors, bool collect_timings, SimulatorConfig config)
+:dt(0.001), rank(rank), n_processors(n_processors), arena_size(0), arena_used(0),
+arena_open(false), collect_timings(collect_timings), config(config){
     stringstream ss;
     ss << "Chunk " << rank;
     label = ss.str();
@@ -41,7 +44,7 @@ void MpiSimulatorChunk::from_file(string filename, hid_t file_plist, hid_t read_
 
     // Get dt
     attr = H5Aopen(f, "dt", H5P_DEFAULT);
-    H5Aread(attr, H5T_NATIVE_DOUBLE, &dt);
+    H5Aread(attr, H5T_NATIVE_DTYPE, &dt);
     H5Aclose(attr);
 
     int component = rank;
@@ -131,8 +134,9 @@ void MpiSimulatorChunk::from_file(string filename, hid_t file_plist, hid_t read_
 
         auto signal_buffer = unique_ptr<dtype>(new dtype[dset_shape[0]]);
 
+        // The file stores doubles, which HDF5 converts to dtype if necessary.
         err = H5Dread(
-            signals, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL,
+            signals, H5T_NATIVE_DTYPE, H5S_ALL, H5S_ALL,
             read_plist, signal_buffer.get());
 
         H5Dclose(signals);
@@ -298,6 +302,30 @@ void MpiSimulatorChunk::finalize_build(){
 }
 
 void MpiSimulatorChunk::finalize_build(MPI_Comm comm){
+    if(config.signal_arena){
+        open_signal_arena();
+    }
+
+    // In index order, so that the arena follows the order of the operators.
+    stable_sort(pending_ops.begin(), pending_ops.end(), compare_indices);
+
+    for(auto& op_spec: pending_ops){
+        build_op(op_spec);
+    }
+
+    for(auto& probe_spec: pending_probes){
+        build_probe(probe_spec);
+    }
+
+    if(config.signal_arena){
+        close_signal_arena();
+    }
+
+    pending_ops.clear();
+    pending_probes.clear();
+
+    index_signals();
+
     if(n_processors != 1){
         sim_log = unique_ptr<SimulationLog>(
             new ParallelSimulationLog(n_processors, rank, probe_info, dt, comm));
@@ -315,6 +343,114 @@ void MpiSimulatorChunk::finalize_build(MPI_Comm comm){
 
     // Important: ensures ops are executed in correct order
     operator_list.sort(compare_op_ptr);
+
+    bool rma = config.transport == TRANSPORT_RMA && n_processors > 1;
+    bool neighbor = config.transport == TRANSPORT_NEIGHBOR && n_processors > 1;
+
+    // With rma, every transfer is an MPIMessage, if only of one member. A
+    // neighbor exchange already packs each round's messages by neighbor.
+    if((config.aggregate_messages || rma) && n_processors > 1 && !neighbor){
+        aggregate_messages(comm);
+    }
+
+    WriteIndex writes;
+    bool replace_dot_incs =
+        (config.sparse_threshold > 0 || config.weight_precision != WEIGHTS_DOUBLE ||
+         config.spike_events) && index_writes(writes);
+
+    if(replace_dot_incs && config.sparse_threshold > 0){
+        use_sparse_dot_incs(writes);
+    }
+
+    // Before use_spike_dot_incs, so that the matrices of products with spikes
+    // are compressed too when a reduced precision is asked for.
+    if(replace_dot_incs && config.weight_precision != WEIGHTS_DOUBLE){
+        use_compressed_dot_incs(writes);
+    }
+
+    if(replace_dot_incs && config.spike_events){
+        use_spike_dot_incs(writes);
+    }
+
+    // Only now are the operators that will write during the simulation known,
+    // and nothing has written to the signals yet.
+    store_initial_values();
+
+    if(config.autotune){
+        for(Operator* op: operator_list){
+            string classname = op->classname();
+            if(classname.compare("DotInc") == 0 || classname.compare("SpikeDotInc") == 0){
+                static_cast<DotInc*>(op)->autotune();
+            }
+        }
+    }
+
+    if(config.merge_ops){
+        operator_list = merge_operators(operator_list, operator_store, signal_table);
+    }
+
+    if(config.schedule_comm && (mpi_sends.size() > 0 || mpi_recvs.size() > 0)){
+        operator_list = schedule_for_communication(operator_list, signal_table);
+    }
+
+    // Once the order of the operators is final.
+    if(config.zero_copy_size > 0 && n_processors > 1 && !rma && !neighbor){
+        transfer_in_place();
+    }
+
+    // Messages are transferred two-sided if there would be too many windows.
+    if(rma && !create_windows(comm)){
+        rma = false;
+    }
+
+    if(neighbor){
+        create_neighbor_exchange(comm);
+    }else if(!rma && config.persistent_requests && n_processors > 1){
+        for(auto& send: mpi_sends){
+            send->make_persistent();
+        }
+
+        for(auto& recv: mpi_recvs){
+            recv->make_persistent();
+        }
+    }
+
+    if(config.use_plan){
+        plan.compile(operator_list);
+
+        build_dbg(
+            "Lowered " << plan.n_lowered() << " of " << plan.size()
+            << " operators into the execution plan.");
+    }
+
+    // Allocate the scratch space of the thread that runs the simulation now,
+    // rather than during the first step.
+    size_t scratch_size = 0;
+    for(Operator* op: operator_list){
+        scratch_size = max(scratch_size, op->scratch_size());
+    }
+
+    scratch_space(scratch_size);
+
+    if(config.n_threads > 1){
+        // Give the ranks on each node their own cores, in case they weren't
+        // bound to disjoint sets of cores when they were launched.
+        unsigned first_core = 0;
+        if(config.hybrid && comm != MPI_COMM_NULL){
+            MPI_Comm node_comm;
+            MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+
+            int node_rank;
+            MPI_Comm_rank(node_comm, &node_rank);
+            MPI_Comm_free(&node_comm);
+
+            first_core = node_rank * config.n_threads;
+        }
+
+        executor = unique_ptr<ParallelExecutor>(
+            new ParallelExecutor(config.n_threads, config.hybrid, first_core));
+        executor->compile(operator_list, signal_table, config.use_plan ? &plan : nullptr);
+    }
 }
 
 void MpiSimulatorChunk::run_n_steps(int steps, bool progress){
@@ -348,11 +484,12 @@ void MpiSimulatorChunk::run_n_steps(int steps, bool progress){
     int n_steps = 0;
 
     for(auto& recv: mpi_recvs){
-        recv->init();
+        recv->init(steps);
     }
 
     for(unsigned step = 0; step < steps; ++step){
-        clock_t begin = clock();
+        // Wall time rather than clock(), which counts the CPU time of all threads.
+        auto begin = chrono::steady_clock::now();
 
         if(!progress && rank == 0 && step % 100 == 0){
             cout << "Master beginning step: " << step << endl;
@@ -365,7 +502,15 @@ void MpiSimulatorChunk::run_n_steps(int steps, bool progress){
             flush_probes();
         }
 
-        if(collect_timings){
+        if(executor){
+            executor->run_step(collect_timings ? per_op_timings : nullptr);
+        }else if(config.use_plan){
+            if(collect_timings){
+                plan.run_timed(per_op_timings);
+            }else{
+                plan();
+            }
+        }else if(collect_timings){
             int op_index = 0;
             for(auto& op: operator_list){
                 clock_t op_begin = clock();
@@ -398,8 +543,8 @@ void MpiSimulatorChunk::run_n_steps(int steps, bool progress){
             ++eta;
         }
 
-        clock_t end = clock();
-        step_times.push_back(double(end - begin) / CLOCKS_PER_SEC);
+        auto end = chrono::steady_clock::now();
+        step_times.push_back(chrono::duration<double>(end - begin).count());
     }
 
     flush_probes();
@@ -412,6 +557,10 @@ void MpiSimulatorChunk::run_n_steps(int steps, bool progress){
         recv->complete();
     }
 
+    if(exchange){
+        exchange->complete();
+    }
+
     clsdbgfile();
 
     if(collect_timings){
@@ -425,13 +574,961 @@ void MpiSimulatorChunk::reset(unsigned seed){
         op->reset(seed + op->get_seed_modifier());
     }
 
-    // TODO: store whether signals are read-only, only reset if they are not.
+    // Only signals that some operator writes have an initial value.
+    for(auto& kv: signal_init_value){
+        signal_map.at(kv.first).fill_with(kv.second);
+    }
+}
+
+void MpiSimulatorChunk::store_initial_values(){
+    signal_init_value.clear();
+
+    // If some operator doesn't declare its accesses, any signal may be written.
+    bool all_written = false;
+    set<const dtype*> written_bases;
+
+    for(Operator* op: operator_list){
+        vector<SignalAccess> accesses;
+        if(!op->get_accesses(accesses)){
+            all_written = true;
+            break;
+        }
+
+        for(auto& access: accesses){
+            if(access.type != ACCESS_READ){
+                written_bases.insert(signal_table.base_of(access.signal.data));
+            }
+        }
+    }
+
+    size_t n_stored = 0, n_total = 0;
+
     for(auto& kv: signal_map){
-        key_type key = kv.first;
-        Signal sig = signal_map.at(key);
-        Signal init_value = signal_init_value.at(key);
-        sig.fill_with(init_value);
+        Signal& base = kv.second;
+        n_total += base.size;
+
+        if(all_written || written_bases.count(base.raw_data) > 0){
+            signal_init_value[kv.first] = base.deep_copy();
+            n_stored += base.size;
+        }
+    }
+
+    build_dbg(
+        "Stored initial values of " << signal_init_value.size() << " of "
+        << signal_map.size() << " base signals (" << n_stored << " of "
+        << n_total << " elements).");
+}
+
+void MpiSimulatorChunk::use_sparse_dot_incs(const WriteIndex& writes){
+    unsigned n_sparse = replace_read_only_dot_incs(writes,
+        [&](const DotInc& dot_inc){ return dot_inc.sparsify(config.sparse_threshold); });
+
+    build_dbg("Replaced " << n_sparse << " DotIncs with SparseDotIncs.");
+}
+
+void MpiSimulatorChunk::use_compressed_dot_incs(const WriteIndex& writes){
+    size_t original_bytes = 0, compressed_bytes = 0;
+    dtype weight_error = 0.0, product_error = 0.0;
+
+    unsigned n_compressed = replace_read_only_dot_incs(writes,
+        [&](const DotInc& dot_inc){
+            unique_ptr<Operator> op = dot_inc.compress(config.weight_precision);
+
+            if(op){
+                CompressedDotInc* compressed = static_cast<CompressedDotInc*>(op.get());
+                original_bytes += compressed->original_bytes();
+                compressed_bytes += compressed->compressed_bytes();
+                weight_error = max(weight_error, compressed->weight_error);
+                product_error = max(product_error, compressed->product_error);
+            }
+
+            return op;
+        });
+
+    stringstream report;
+    report << "Chunk " << rank << ": stored the matrices of " << n_compressed
+           << " DotIncs as " << weight_precision_name(config.weight_precision)
+           << ", using " << compressed_bytes << " bytes instead of " << original_bytes
+           << ". Largest error of a matrix entry (relative to the largest entry): "
+           << weight_error << ". Largest relative error of a product: "
+           << product_error << "." << endl;
+    cout << report.str();
+}
+
+bool MpiSimulatorChunk::index_writes(WriteIndex& writes) const{
+    for(Operator* op: operator_list){
+        vector<SignalAccess> accesses;
+        if(!op->get_accesses(accesses)){
+            return false;
+        }
+
+        for(auto& access: accesses){
+            if(access.type != ACCESS_READ){
+                SignalExtent extent(access.signal, signal_table);
+                writes[extent.base].push_back(make_pair(op, extent));
+            }
+        }
+    }
+
+    return true;
+}
+
+const Operator* MpiSimulatorChunk::find_writer(
+        const WriteIndex& writes, const SignalExtent& extent, const Operator* ignore){
+
+    auto location = writes.find(extent.base);
+    if(location == writes.end()){
+        return nullptr;
+    }
+
+    for(auto& w: location->second){
+        if(w.first != ignore && w.second.overlaps(extent)){
+            return w.first;
+        }
+    }
+
+    return nullptr;
+}
+
+unsigned MpiSimulatorChunk::replace_read_only_dot_incs(
+        const WriteIndex& writes,
+        function<unique_ptr<Operator>(const DotInc&)> convert){
+
+    unsigned n_replaced = 0;
+
+    for(auto it = operator_list.begin(); it != operator_list.end(); ++it){
+        if((*it)->classname().compare("DotInc") != 0){
+            continue;
+        }
+
+        DotInc* dot_inc = static_cast<DotInc*>(*it);
+        SignalExtent A_extent(dot_inc->get_A(), signal_table);
+
+        if(find_writer(writes, A_extent)){
+            continue;
+        }
+
+        unique_ptr<Operator> replacement = convert(*dot_inc);
+        if(!replacement){
+            continue;
+        }
+
+        build_dbg("Replacing DotInc with:" << endl << *replacement);
+
+        replace_op(it, move(replacement));
+        n_replaced++;
     }
+
+    return n_replaced;
+}
+
+void MpiSimulatorChunk::use_spike_dot_incs(const WriteIndex& writes){
+    map<const dtype*, LIF*> spiking;
+
+    for(Operator* op: operator_list){
+        string classname = op->classname();
+        if(classname.compare("LIF") == 0 || classname.compare("AdaptiveLIF") == 0){
+            LIF* lif = static_cast<LIF*>(op);
+            spiking[lif->get_output().data] = lif;
+        }
+    }
+
+    unsigned n_spike = 0;
+
+    for(auto it = operator_list.begin(); it != operator_list.end(); ++it){
+        if((*it)->classname().compare("DotInc") != 0){
+            continue;
+        }
+
+        DotInc* dot_inc = static_cast<DotInc*>(*it);
+        const SignalView& X = dot_inc->get_X();
+
+        auto lif_location = spiking.find(X.data);
+        if(lif_location == spiking.end()){
+            continue;
+        }
+
+        // X has to be exactly the neuron output, and nothing but the neuron
+        // operator may write to it, so that the spike list always describes X.
+        LIF* lif = lif_location->second;
+        const SignalView& output = lif->get_output();
+
+        if(X.shape1 != output.shape1 || X.shape2 != 1 || X.stride1 != output.stride1){
+            continue;
+        }
+
+        if(find_writer(writes, SignalExtent(X, signal_table), lif)){
+            continue;
+        }
+
+        unique_ptr<Operator> spike_dot_inc = dot_inc->with_spikes(lif->get_spike_list());
+        if(!spike_dot_inc){
+            continue;
+        }
+
+        build_dbg("Replacing DotInc with SpikeDotInc:" << endl << *spike_dot_inc);
+
+        replace_op(it, move(spike_dot_inc));
+        n_spike++;
+    }
+
+    build_dbg("Replaced " << n_spike << " DotIncs with SpikeDotIncs.");
+}
+
+void MpiSimulatorChunk::index_signals(){
+    signal_table.clear();
+
+    for(auto& kv: signal_map){
+        signal_table.add(kv.first, kv.second);
+    }
+}
+
+void MpiSimulatorChunk::open_signal_arena(){
+    index_signals();
+
+    arena_pinned.clear();
+    arena_placed.clear();
+
+    for(Operator* op: operator_list){
+        vector<SignalAccess> accesses;
+        if(!op->get_accesses(accesses)){
+            build_dbg("Not using a signal arena, since " << op->classname()
+                      << " doesn't declare its accesses.");
+            return;
+        }
+
+        for(auto& access: accesses){
+            arena_pinned.insert(signal_table.base_of(access.signal.data));
+        }
+    }
+
+    arena_size = 0;
+    for(auto& kv: signal_map){
+        if(arena_pinned.count(kv.second.raw_data) == 0){
+            arena_size += arena_padded_size(kv.second.size);
+        }
+    }
+
+    arena = allocate_signal_arena(arena_size, config.huge_pages);
+    arena_used = 0;
+    arena_open = true;
+}
+
+void MpiSimulatorChunk::place_in_arena(key_type key){
+    if(!arena_open || arena_placed.count(key) > 0){
+        return;
+    }
+
+    Signal& base = signal_map.at(key);
+    if(arena_pinned.count(base.raw_data) > 0){
+        return;
+    }
+
+    size_t padded_size = arena_padded_size(base.size);
+
+    // Shares ownership of the arena.
+    shared_ptr<dtype> data(arena, arena.get() + arena_used);
+
+    copy(base.raw_data, base.raw_data + base.size, data.get());
+    fill(data.get() + base.size, data.get() + padded_size, 0.0);
+
+    base.data = data;
+    base.raw_data = data.get();
+
+    arena_used += padded_size;
+    arena_placed.insert(key);
+}
+
+void MpiSimulatorChunk::close_signal_arena(){
+    if(!arena_open){
+        return;
+    }
+
+    // Signals that nothing refers to go last.
+    for(auto& kv: signal_map){
+        place_in_arena(kv.first);
+    }
+
+    build_dbg("Placed " << arena_placed.size() << " of " << signal_map.size()
+              << " base signals in an arena of " << arena_size << " elements.");
+
+    arena_open = false;
+    arena_pinned.clear();
+    arena_placed.clear();
+}
+
+// Send outgoing[r] to each rank r in ``comm``, and return what each rank
+// sent to this one. All ranks in ``comm`` must call this.
+static vector<vector<int>> exchange_ints(const vector<vector<int>>& outgoing, MPI_Comm comm){
+    int n_processors = outgoing.size();
+
+    vector<int> send_counts(n_processors), send_displs(n_processors);
+    vector<int> recv_counts(n_processors), recv_displs(n_processors);
+    vector<int> send_data;
+
+    for(int r = 0; r < n_processors; r++){
+        send_counts[r] = outgoing[r].size();
+        send_displs[r] = send_data.size();
+        send_data.insert(send_data.end(), outgoing[r].begin(), outgoing[r].end());
+    }
+
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, comm);
+
+    int n_incoming = 0;
+    for(int r = 0; r < n_processors; r++){
+        recv_displs[r] = n_incoming;
+        n_incoming += recv_counts[r];
+    }
+
+    vector<int> recv_data(n_incoming);
+
+    MPI_Alltoallv(
+        send_data.data(), send_counts.data(), send_displs.data(), MPI_INT,
+        recv_data.data(), recv_counts.data(), recv_displs.data(), MPI_INT, comm);
+
+    vector<vector<int>> incoming(n_processors);
+    for(int r = 0; r < n_processors; r++){
+        incoming[r].assign(
+            recv_data.begin() + recv_displs[r],
+            recv_data.begin() + recv_displs[r] + recv_counts[r]);
+    }
+
+    return incoming;
+}
+
+// Rank, stretch between MPIRecvs and is_update of an aggregated message.
+typedef tuple<int, int, int> MessageKey;
+
+// Make the MPISends or MPIRecvs in each group (ordered by tag) share an
+// MPIMessage, if there are at least ``min_members``. Returns the number of
+// messages.
+template <class MPIOp>
+static unsigned join_messages(
+        map<MessageKey, map<int, MPIOp*>>& groups, MPI_Comm comm, unsigned min_members){
+    for(auto& kv: groups){
+        auto& members = kv.second;
+        if(members.size() < min_members){
+            continue;
+        }
+
+        int size = 0;
+        for(auto& member: members){
+            size += member.second->get_size();
+        }
+
+        auto message = make_shared<MPIMessage>(
+            get<0>(kv.first), members.begin()->first, size, members.size(), get<2>(kv.first));
+        message->set_communicator(comm);
+
+        int offset = 0;
+        for(auto& member: members){
+            member.second->join_message(message, offset, offset == 0);
+            offset += member.second->get_size();
+        }
+    }
+
+    return groups.size();
+}
+
+void MpiSimulatorChunk::aggregate_messages(MPI_Comm comm){
+    // Number the stretches between MPIRecvs that the sends are in.
+    map<int, int> send_slot;
+    int slot = 0;
+
+    for(Operator* op: operator_list){
+        string classname = op->classname();
+        if(classname.compare("MPIRecv") == 0){
+            slot++;
+        }else if(classname.compare("MPISend") == 0){
+            send_slot[static_cast<MPISend*>(op)->get_tag()] = slot;
+        }
+    }
+
+    // Tell each destination the stretch of every send, and each source
+    // whether every receive is an update, as (is_recv, tag, value) triples.
+    vector<vector<int>> outgoing(n_processors);
+
+    for(auto& send: mpi_sends){
+        vector<int>& out = outgoing[send->get_dst()];
+        out.push_back(0);
+        out.push_back(send->get_tag());
+        out.push_back(send_slot.at(send->get_tag()));
+    }
+
+    for(auto& recv: mpi_recvs){
+        vector<int>& out = outgoing[recv->get_src()];
+        out.push_back(1);
+        out.push_back(recv->get_tag());
+        out.push_back(recv->get_is_update());
+    }
+
+    vector<vector<int>> incoming = exchange_ints(outgoing, comm);
+
+    // The stretch of the send matching each of our receives, and whether
+    // the receive matching each of our sends is an update, keyed by
+    // (rank, tag).
+    map<pair<int, int>, int> recv_slot, send_is_update;
+
+    for(int r = 0; r < n_processors; r++){
+        for(unsigned i = 0; i < incoming[r].size(); i += 3){
+            auto key = make_pair(r, incoming[r][i + 1]);
+            if(incoming[r][i] == 0){
+                recv_slot[key] = incoming[r][i + 2];
+            }else{
+                send_is_update[key] = incoming[r][i + 2];
+            }
+        }
+    }
+
+    // Both sides group the same sends and receives by (rank, stretch,
+    // is_update), and order the members of each message by tag. Sends and
+    // receives large enough to be transferred in place are left on their
+    // own; both sides know their size. With the rma transport, every send
+    // and receive needs a message, which is of its own unless aggregating.
+    bool rma = config.transport == TRANSPORT_RMA;
+    bool separate = rma && !config.aggregate_messages;
+
+    auto in_place = [&](int size){
+        return !rma && config.zero_copy_size > 0 && unsigned(size) >= config.zero_copy_size;
+    };
+
+    map<MessageKey, map<int, MPISend*>> send_groups;
+    for(auto& send: mpi_sends){
+        auto key = make_pair(send->get_dst(), send->get_tag());
+
+        auto is_update = send_is_update.find(key);
+        if(is_update == send_is_update.end()){
+            stringstream msg;
+            msg << "In chunk with rank " << rank << ", no MPIRecv on rank "
+                << key.first << " matches the MPISend with tag " << key.second << ".";
+            throw runtime_error(msg.str());
+        }
+
+        if(in_place(send->get_size())){
+            continue;
+        }
+
+        int stretch = separate ? key.second : send_slot.at(key.second);
+        MessageKey message_key(key.first, stretch, is_update->second);
+        send_groups[message_key][key.second] = send.get();
+    }
+
+    map<MessageKey, map<int, MPIRecv*>> recv_groups;
+    for(auto& recv: mpi_recvs){
+        auto key = make_pair(recv->get_src(), recv->get_tag());
+
+        auto slot = recv_slot.find(key);
+        if(slot == recv_slot.end()){
+            stringstream msg;
+            msg << "In chunk with rank " << rank << ", no MPISend on rank "
+                << key.first << " matches the MPIRecv with tag " << key.second << ".";
+            throw runtime_error(msg.str());
+        }
+
+        if(in_place(recv->get_size())){
+            continue;
+        }
+
+        int stretch = separate ? key.second : slot->second;
+        MessageKey message_key(key.first, stretch, recv->get_is_update());
+        recv_groups[message_key][key.second] = recv.get();
+    }
+
+    unsigned min_members = rma ? 1 : 2;
+    unsigned n_messages =
+        join_messages(send_groups, comm, min_members) +
+        join_messages(recv_groups, comm, min_members);
+
+    build_dbg(
+        "Aggregated " << mpi_sends.size() << " MPISends and " << mpi_recvs.size()
+        << " MPIRecvs into " << n_messages << " messages.");
+}
+
+void MpiSimulatorChunk::transfer_in_place(){
+    vector<Operator*> ops(operator_list.begin(), operator_list.end());
+    unsigned n_ops = ops.size();
+
+    // The extents each operator touches, and whether it only reads them.
+    vector<vector<pair<SignalExtent, bool>>> touched(n_ops);
+    map<Operator*, unsigned> position;
+
+    for(unsigned i = 0; i < n_ops; i++){
+        vector<SignalAccess> accesses;
+        if(!ops[i]->get_accesses(accesses)){
+            return;
+        }
+
+        for(auto& access: accesses){
+            touched[i].push_back(make_pair(
+                SignalExtent(access.signal, signal_table), access.type == ACCESS_READ));
+        }
+
+        position[ops[i]] = i;
+    }
+
+    vector<SignalExtent> probed;
+    for(auto& kv: probe_map){
+        probed.push_back(SignalExtent(kv.second->get_signal(), signal_table));
+    }
+
+    // Operators to place before and after each operator.
+    map<Operator*, list<unique_ptr<Operator>>> before, after;
+    unsigned n_sends = 0, n_recvs = 0;
+
+    for(auto& send: mpi_sends){
+        if(send->is_in_message() || unsigned(send->get_size()) < config.zero_copy_size){
+            continue;
+        }
+
+        SignalExtent content(send->get_content(), signal_table);
+        unsigned s = position.at(send.get());
+
+        send->send_in_place();
+        n_sends++;
+
+        // The first writer after the send, wrapping around to the next step.
+        for(unsigned k = 1; k < n_ops; k++){
+            unsigned i = (s + k) % n_ops;
+
+            bool writes = any_of(touched[i].begin(), touched[i].end(),
+                [&](const pair<SignalExtent, bool>& t){
+                    return !t.second && t.first.overlaps(content); });
+
+            if(writes){
+                unique_ptr<Operator> wait(new MPISendWait(send.get()));
+                wait->set_index(ops[i]->get_index());
+                before[ops[i]].push_back(move(wait));
+                break;
+            }
+        }
+    }
+
+    for(auto& recv: mpi_recvs){
+        if(recv->is_in_message() || unsigned(recv->get_size()) < config.zero_copy_size){
+            continue;
+        }
+
+        SignalExtent content(recv->get_content(), signal_table);
+        unsigned r = position.at(recv.get());
+
+        bool safe = none_of(probed.begin(), probed.end(),
+            [&](const SignalExtent& p){ return p.overlaps(content); });
+
+        unsigned last = r;
+        for(unsigned i = 0; i < n_ops && safe; i++){
+            if(i == r){
+                continue;
+            }
+
+            for(auto& t: touched[i]){
+                if(t.first.overlaps(content)){
+                    safe = safe && i > r && t.second;
+                    last = max(last, i);
+                }
+            }
+        }
+
+        if(safe){
+            recv->receive_in_place();
+            n_recvs++;
+
+            unique_ptr<Operator> post(new MPIRecvPost(recv.get()));
+            post->set_index(ops[last]->get_index());
+            after[ops[last]].push_back(move(post));
+        }
+    }
+
+    operator_list.clear();
+    for(Operator* op: ops){
+        for(auto& other: before[op]){
+            operator_list.push_back(other.get());
+            operator_store.push_back(move(other));
+        }
+
+        operator_list.push_back(op);
+
+        for(auto& other: after[op]){
+            operator_list.push_back(other.get());
+            operator_store.push_back(move(other));
+        }
+    }
+
+    build_dbg(
+        "Transferring " << n_sends << " of " << mpi_sends.size() << " MPISends and "
+        << n_recvs << " of " << mpi_recvs.size() << " MPIRecvs in place.");
+}
+
+bool MpiSimulatorChunk::create_windows(MPI_Comm comm){
+    // The messages this chunk receives and sends, keyed by (rank, tag).
+    map<pair<int, int>, shared_ptr<MPIMessage>> incoming, outgoing;
+
+    for(auto& recv: mpi_recvs){
+        auto message = recv->get_message();
+        incoming[make_pair(message->rank, message->tag)] = message;
+    }
+
+    for(auto& send: mpi_sends){
+        auto message = send->get_message();
+        outgoing[make_pair(message->rank, message->tag)] = message;
+    }
+
+    // Incoming message i of every chunk is received in windows 2i and 2i+1.
+    // A chunk can have only one exposure epoch per window at a time, so
+    // each of its incoming messages needs windows of its own, but the access
+    // epochs of a chunk's sends are never open at the same time.
+    int n_incoming = incoming.size(), max_incoming;
+    MPI_Allreduce(&n_incoming, &max_incoming, 1, MPI_INT, MPI_MAX, comm);
+
+    if(2 * (unsigned) max_incoming > config.max_windows){
+        if(rank == 0){
+            cout << "A chunk receives " << max_incoming << " messages per step, which "
+                 << "would need " << 2 * max_incoming << " windows, but at most "
+                 << config.max_windows << " are allowed (see --maxwindows). "
+                 << "Transferring messages two-sided instead of with rma." << endl;
+        }
+
+        return false;
+    }
+
+    // Number the incoming messages, and tell each source the numbers of its
+    // messages as (tag, number) pairs.
+    vector<shared_ptr<MPIMessage>> numbered;
+    vector<vector<int>> numbers(n_processors);
+
+    for(auto& kv: incoming){
+        numbers[kv.first.first].push_back(kv.first.second);
+        numbers[kv.first.first].push_back(numbered.size());
+        numbered.push_back(kv.second);
+    }
+
+    vector<vector<int>> dst_numbers = exchange_ints(numbers, comm);
+
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, const_cast<char*>("no_locks"), const_cast<char*>("true"));
+
+    windows.resize(2 * max_incoming);
+
+    for(int i = 0; i < max_incoming; i++){
+        for(unsigned parity = 0; parity < 2; parity++){
+            dtype* base = nullptr;
+            MPI_Aint size = 0;
+
+            if(i < n_incoming){
+                base = numbered[i]->window_buffer(parity);
+                size = numbered[i]->buffer.size * sizeof(dtype);
+            }
+
+            MPI_Win_create(base, size, sizeof(dtype), info, comm, &windows[2 * i + parity]);
+        }
+    }
+
+    MPI_Info_free(&info);
+
+    for(int i = 0; i < n_incoming; i++){
+        numbered[i]->use_windows(windows[2 * i], windows[2 * i + 1]);
+    }
+
+    for(int r = 0; r < n_processors; r++){
+        for(unsigned j = 0; j < dst_numbers[r].size(); j += 2){
+            int i = dst_numbers[r][j + 1];
+            outgoing.at(make_pair(r, dst_numbers[r][j]))->use_windows(
+                windows[2 * i], windows[2 * i + 1]);
+        }
+    }
+
+    build_dbg(
+        "Created " << windows.size() << " windows for " << incoming.size()
+        << " incoming and " << outgoing.size() << " outgoing messages.");
+
+    return true;
+}
+
+void MpiSimulatorChunk::create_neighbor_exchange(MPI_Comm comm){
+    vector<Operator*> ops(operator_list.begin(), operator_list.end());
+    unsigned n_ops = ops.size();
+
+    // Tell each source whether each of our receives is an update, as
+    // (tag, is_update) pairs.
+    vector<vector<int>> outgoing(n_processors);
+    for(auto& recv: mpi_recvs){
+        outgoing[recv->get_src()].push_back(recv->get_tag());
+        outgoing[recv->get_src()].push_back(recv->get_is_update());
+    }
+
+    vector<vector<int>> incoming = exchange_ints(outgoing, comm);
+
+    // Keyed by (rank, tag), like the rounds below.
+    map<pair<int, int>, bool> send_is_update;
+    for(int r = 0; r < n_processors; r++){
+        for(unsigned i = 0; i < incoming[r].size(); i += 2){
+            send_is_update[make_pair(r, incoming[r][i])] = incoming[r][i + 1];
+        }
+    }
+
+    for(auto& send: mpi_sends){
+        auto key = make_pair(send->get_dst(), send->get_tag());
+        if(send_is_update.find(key) == send_is_update.end()){
+            stringstream msg;
+            msg << "In chunk with rank " << rank << ", no MPIRecv on rank "
+                << key.first << " matches the MPISend with tag " << key.second << ".";
+            throw runtime_error(msg.str());
+        }
+    }
+
+    // A send is in the round after the latest round of the receives before
+    // it in the operator list (round 0 if there are none), and a receive is
+    // in the round of its send. Receives of updates don't count, since they
+    // only need the previous step; all updates are exchanged in an extra
+    // round at the end of a step. Rounds depend on the rounds of other
+    // chunks, so all chunks iterate until none change, which takes as many
+    // iterations as the longest chain of messages within a step.
+    map<pair<int, int>, int> send_round, recv_round;
+    for(auto& recv: mpi_recvs){
+        recv_round[make_pair(recv->get_src(), recv->get_tag())] = 0;
+    }
+
+    int n_sends = mpi_sends.size(), n_messages;
+    MPI_Allreduce(&n_sends, &n_messages, 1, MPI_INT, MPI_SUM, comm);
+
+    for(int iteration = 0; ; iteration++){
+        if(iteration > n_messages){
+            throw runtime_error(
+                "The messages between chunks depend on each other in a cycle within a step.");
+        }
+
+        int latest = -1;
+        for(Operator* op: ops){
+            string classname = op->classname();
+            if(classname.compare("MPIRecv") == 0){
+                auto recv = static_cast<MPIRecv*>(op);
+                if(!recv->get_is_update()){
+                    latest = max(latest, recv_round.at(make_pair(recv->get_src(), recv->get_tag())));
+                }
+            }else if(classname.compare("MPISend") == 0){
+                auto send = static_cast<MPISend*>(op);
+                send_round[make_pair(send->get_dst(), send->get_tag())] = latest + 1;
+            }
+        }
+
+        vector<vector<int>> rounds_out(n_processors);
+        for(auto& kv: send_round){
+            if(!send_is_update.at(kv.first)){
+                rounds_out[kv.first.first].push_back(kv.first.second);
+                rounds_out[kv.first.first].push_back(kv.second);
+            }
+        }
+
+        vector<vector<int>> rounds_in = exchange_ints(rounds_out, comm);
+
+        int changed = 0, any_changed;
+        for(int r = 0; r < n_processors; r++){
+            for(unsigned i = 0; i < rounds_in[r].size(); i += 2){
+                int& round = recv_round.at(make_pair(r, rounds_in[r][i]));
+                if(round != rounds_in[r][i + 1]){
+                    round = rounds_in[r][i + 1];
+                    changed = 1;
+                }
+            }
+        }
+
+        MPI_Allreduce(&changed, &any_changed, 1, MPI_INT, MPI_LOR, comm);
+        if(!any_changed){
+            break;
+        }
+    }
+
+    int n_rounds = 0, has_updates = 0;
+    for(auto& send: mpi_sends){
+        auto key = make_pair(send->get_dst(), send->get_tag());
+        if(send_is_update.at(key)){
+            has_updates = 1;
+        }else{
+            n_rounds = max(n_rounds, send_round.at(key) + 1);
+        }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &n_rounds, 1, MPI_INT, MPI_MAX, comm);
+    MPI_Allreduce(MPI_IN_PLACE, &has_updates, 1, MPI_INT, MPI_LOR, comm);
+
+    int update_round = n_rounds;
+    int n_total_rounds = n_rounds + has_updates;
+
+    for(auto& recv: mpi_recvs){
+        if(recv->get_is_update()){
+            recv_round[make_pair(recv->get_src(), recv->get_tag())] = update_round;
+        }
+    }
+
+    for(auto& kv: send_round){
+        if(send_is_update.at(kv.first)){
+            kv.second = update_round;
+        }
+    }
+
+    // The members of each round, ordered by neighbor and then by tag, and
+    // the number of values exchanged with each neighbor per step, which the
+    // library may use to renumber the chunks when reorder is allowed. That
+    // only changes their ranks in the graph communicator, which aren't used
+    // otherwise.
+    vector<map<pair<int, int>, MPISend*>> round_sends(n_total_rounds);
+    vector<map<pair<int, int>, MPIRecv*>> round_recvs(n_total_rounds);
+    map<int, int> destination_weights, source_weights;
+
+    for(auto& send: mpi_sends){
+        auto key = make_pair(send->get_dst(), send->get_tag());
+        round_sends[send_round.at(key)][key] = send.get();
+        destination_weights[key.first] += send->get_size();
+    }
+
+    for(auto& recv: mpi_recvs){
+        auto key = make_pair(recv->get_src(), recv->get_tag());
+        round_recvs[recv_round.at(key)][key] = recv.get();
+        source_weights[key.first] += recv->get_size();
+    }
+
+    vector<int> destinations, dst_weights, sources, src_weights;
+    map<int, unsigned> destination_index, source_index;
+
+    for(auto& kv: destination_weights){
+        destination_index[kv.first] = destinations.size();
+        destinations.push_back(kv.first);
+        dst_weights.push_back(kv.second);
+    }
+
+    for(auto& kv: source_weights){
+        source_index[kv.first] = sources.size();
+        sources.push_back(kv.first);
+        src_weights.push_back(kv.second);
+    }
+
+    MPI_Comm graph_comm;
+    MPI_Dist_graph_create_adjacent(
+        comm,
+        sources.size(), sources.data(),
+        sources.empty() ? MPI_WEIGHTS_EMPTY : src_weights.data(),
+        destinations.size(), destinations.data(),
+        destinations.empty() ? MPI_WEIGHTS_EMPTY : dst_weights.data(),
+        MPI_INFO_NULL, 1, &graph_comm);
+
+    exchange = make_shared<NeighborExchange>(graph_comm, n_total_rounds);
+
+    for(int round = 0; round < n_total_rounds; round++){
+        vector<int> send_counts(destinations.size(), 0), recv_counts(sources.size(), 0);
+
+        for(auto& kv: round_sends[round]){
+            send_counts[destination_index.at(kv.first.first)] += kv.second->get_size();
+        }
+
+        for(auto& kv: round_recvs[round]){
+            recv_counts[source_index.at(kv.first.first)] += kv.second->get_size();
+        }
+
+        exchange->set_layout(round, send_counts, recv_counts);
+
+        int offset = 0;
+        for(auto& kv: round_sends[round]){
+            kv.second->join_exchange(exchange, round, offset);
+            offset += kv.second->get_size();
+        }
+
+        offset = 0;
+        for(auto& kv: round_recvs[round]){
+            kv.second->join_exchange(exchange, round, offset);
+            offset += kv.second->get_size();
+        }
+    }
+
+    // Place the starts and waits in the gaps between operators (gap i is
+    // right before operator i). Each round starts after its last MPISend
+    // and after the previous round has started, and is completed right
+    // before the first MPIRecv of the round or a later one. So on every
+    // chunk, rounds are started and completed in the same order, and each
+    // round is started before it is completed, which means that a chunk
+    // waiting on a round only ever waits for chunks that will get to start
+    // it. The updates of a step are completed at the start of the next.
+    vector<unsigned> start_gap(n_total_rounds, 0), wait_gap(n_total_rounds, n_ops);
+
+    map<Operator*, unsigned> position;
+    for(unsigned i = 0; i < n_ops; i++){
+        position[ops[i]] = i;
+    }
+
+    unsigned gap = 0;
+    for(int round = 0; round < n_total_rounds; round++){
+        for(auto& kv: round_sends[round]){
+            gap = max(gap, position.at(kv.second) + 1);
+        }
+
+        start_gap[round] = gap;
+
+        for(int later = round; later < n_rounds; later++){
+            for(auto& kv: round_recvs[later]){
+                wait_gap[round] = min(wait_gap[round], position.at(kv.second));
+            }
+        }
+    }
+
+    if(has_updates){
+        wait_gap[update_round] = 0;
+    }
+
+    vector<list<unique_ptr<Operator>>> inserted(n_ops + 1);
+
+    if(has_updates){
+        inserted[0].push_back(
+            unique_ptr<Operator>(new NeighborWait(exchange, update_round)));
+    }
+
+    for(int round = 0; round < n_total_rounds; round++){
+        inserted[start_gap[round]].push_back(
+            unique_ptr<Operator>(new NeighborStart(exchange, round)));
+    }
+
+    for(int round = 0; round < n_rounds; round++){
+        inserted[wait_gap[round]].push_back(
+            unique_ptr<Operator>(new NeighborWait(exchange, round)));
+    }
+
+    operator_list.clear();
+    for(unsigned i = 0; i <= n_ops; i++){
+        for(auto& op: inserted[i]){
+            if(n_ops > 0){
+                op->set_index(ops[min(i, n_ops - 1)]->get_index());
+            }
+
+            operator_list.push_back(op.get());
+            operator_store.push_back(move(op));
+        }
+
+        if(i < n_ops){
+            operator_list.push_back(ops[i]);
+        }
+    }
+
+    build_dbg(
+        "Exchanging " << mpi_sends.size() << " MPISends and " << mpi_recvs.size()
+        << " MPIRecvs with " << destinations.size() << " destinations and "
+        << sources.size() << " sources in " << n_total_rounds << " rounds per step.");
+}
+
+void MpiSimulatorChunk::free_windows(){
+    for(auto& window: windows){
+        MPI_Win_free(&window);
+    }
+
+    windows.clear();
+}
+
+void MpiSimulatorChunk::replace_op(list<Operator*>::iterator position, unique_ptr<Operator> op){
+    Operator* old_op = *position;
+
+    op->set_index(old_op->get_index());
+    *position = op.get();
+    operator_store.push_back(move(op));
+
+    operator_store.remove_if(
+        [=](const unique_ptr<Operator>& stored){ return stored.get() == old_op; });
 }
 
 void MpiSimulatorChunk::add_base_signal(key_type key, Signal signal){
@@ -447,7 +1544,6 @@ void MpiSimulatorChunk::add_base_signal(key_type key, Signal signal){
             throw logic_error(msg.str());
         }
     }else{
-        signal_init_value[key] = signal.deep_copy();
         signal_map[key] = signal;
     }
 }
@@ -464,6 +1560,8 @@ Signal MpiSimulatorChunk::get_signal_view(
         throw out_of_range(msg.str());
     }
 
+    place_in_arena(key);
+
     build_dbg("Getting view with args -");
     build_dbg("label: " << label);
     build_dbg("key: " << key);
@@ -500,10 +1598,20 @@ Signal MpiSimulatorChunk::get_signal(key_type key){
         throw out_of_range(msg.str());
     }
 
+    place_in_arena(key);
+
     return signal_map.at(key);
 }
 
 void MpiSimulatorChunk::add_op(OpSpec op_spec){
+    if(config.signal_arena){
+        pending_ops.push_back(op_spec);
+    }else{
+        build_op(op_spec);
+    }
+}
+
+void MpiSimulatorChunk::build_op(OpSpec op_spec){
     string type_string = op_spec.type_string;
     vector<string>& args = op_spec.arguments;
     float index = op_spec.index;
@@ -679,8 +1787,8 @@ void MpiSimulatorChunk::add_op(OpSpec op_spec){
             Signal input = get_signal_view(args[0]);
             Signal output = get_signal_view(args[1]);
 
-            Signal numerator = python_list_to_signal(args[2], false);
-            Signal denominator = python_list_to_signal(args[3], false);
+            Signal numerator = add_constant_signal(python_list_to_signal(args[2], false));
+            Signal denominator = add_constant_signal(python_list_to_signal(args[3], false));
 
             add_op(index, unique_ptr<Operator>(new Synapse(input, output, numerator, denominator)));
 
@@ -713,7 +1821,7 @@ void MpiSimulatorChunk::add_op(OpSpec op_spec){
         }else if(type_string.compare("WhiteSignal") == 0){
 
             bool get_size = true;
-            Signal coefs = python_list_to_signal(args[0], get_size);
+            Signal coefs = add_constant_signal(python_list_to_signal(args[0], get_size));
 
             Signal output = get_signal_view(args[1]);
             Signal time = get_signal_view(args[2]);
@@ -726,7 +1834,7 @@ void MpiSimulatorChunk::add_op(OpSpec op_spec){
         }else if(type_string.compare("PresentInput") == 0){
 
             bool get_size = true;
-            Signal input = python_list_to_signal(args[0], get_size);
+            Signal input = add_constant_signal(python_list_to_signal(args[0], get_size));
 
             Signal output = get_signal_view(args[1]);
             Signal time = get_signal_view(args[2]);
@@ -777,7 +1885,7 @@ void MpiSimulatorChunk::add_op(OpSpec op_spec){
             Signal delta = get_signal_view(args[3]);
             Signal learning_signal = get_signal_view(args[4]);
 
-            Signal scale = python_list_to_signal(args[5], false);
+            Signal scale = add_constant_signal(python_list_to_signal(args[5], false));
 
             dtype learning_rate = boost::lexical_cast<dtype>(args[6]);
             dtype dt = boost::lexical_cast<dtype>(args[7]);
@@ -864,6 +1972,11 @@ void MpiSimulatorChunk::add_op(OpSpec op_spec){
     }
 }
 
+Signal MpiSimulatorChunk::add_constant_signal(Signal signal){
+    constant_signals.push_back(signal);
+    return signal;
+}
+
 void MpiSimulatorChunk::add_op(float index, unique_ptr<Operator> op){
     build_dbg(
         "At index " << index << ", adding op:" << endl << *(op.get()));
@@ -896,6 +2009,14 @@ void MpiSimulatorChunk::add_mpi_recv(float index, int src, int tag, Signal conte
 }
 
 void MpiSimulatorChunk::add_probe(ProbeSpec ps){
+    if(config.signal_arena){
+        pending_probes.push_back(ps);
+    }else{
+        build_probe(ps);
+    }
+}
+
+void MpiSimulatorChunk::build_probe(ProbeSpec ps){
     Signal signal = get_signal_view(ps.signal_spec);
     probe_map[ps.probe_key] = shared_ptr<Probe>(new Probe(signal, ps.period));
 }
@@ -976,6 +2097,17 @@ void MpiSimulatorChunk::process_timing_data(
     runtimes_ss << endl << "Rank " << rank << " runtimes." << endl;
     runtimes_ss << "Mean seconds-per-step: " << mean << ", stdev: " << stdev << endl;
 
+    if(mpi_recvs.size() > 0){
+        double wait_time = 0.0;
+        for(auto& recv: mpi_recvs){
+            wait_time += recv->get_wait_time();
+        }
+
+        runtimes_ss << "Mean seconds-per-step waiting in MPIRecv: "
+                    << wait_time / double(n_steps)
+                    << " (scheduled for communication: " << config.schedule_comm << ")" << endl;
+    }
+
     for(auto& p : class_cumulative){
         string class_name = p.first;
         double value = p.second / class_count[class_name] / double(n_steps);
@@ -1034,7 +2166,18 @@ string MpiSimulatorChunk::to_string() const{
 
     out << "** Operators: **" << endl;
     for(auto const& op : operator_list){
-        out << *op << endl;
+        out << *op;
+
+        // Operators only hold views, so look up which signals they are.
+        vector<SignalAccess> accesses;
+        if(op->get_accesses(accesses)){
+            out << "Accesses:" << endl;
+            for(auto const& access: accesses){
+                out << "    " << signal_table.describe(access.signal) << endl;
+            }
+        }
+
+        out << endl;
     }
     out << endl;
 
@@ -2,13 +2,17 @@
 
 #include <map>
 #include <list>
+#include <set>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <memory> // unique_ptr
+#include <functional>
 #include <algorithm> // sort_stable
 #include <utility> // pair
+#include <tuple>
 #include <exception>
+#include <chrono>
 #include <string>
 #include <assert.h>
 
@@ -21,6 +25,11 @@
 #include "mpi_operator.hpp"
 #include "spaun.hpp"
 #include "probe.hpp"
+#include "plan.hpp"
+#include "op_graph.hpp"
+#include "executor.hpp"
+#include "config.hpp"
+#include "arena.hpp"
 #include "sim_log.hpp"
 #include "psim_log.hpp"
 #include "ezProgressBar-2.1.1/ezETAProgressBar.hpp"
@@ -36,8 +45,10 @@ const int FLUSH_PROBES_EVERY = 1000;
 class MpiSimulatorChunk{
 
 public:
-    MpiSimulatorChunk(bool collect_timings);
-    MpiSimulatorChunk(int rank, int n_processors, bool collect_timings);
+    MpiSimulatorChunk(bool collect_timings, SimulatorConfig config=SimulatorConfig());
+    MpiSimulatorChunk(
+        int rank, int n_processors, bool collect_timings,
+        SimulatorConfig config=SimulatorConfig());
     string classname() const { return "MpiSimulatorChunk"; }
 
     /* Add simulation objects to the chunk from an HDF5 file. */
@@ -48,7 +59,8 @@ public:
      * process telling the worker to begin a simulation. */
     void run_n_steps(int steps, bool progress);
 
-    /* Reset the chunk. */
+    /* Reset the chunk: resets the operators and restores the initial values
+     * of the signals that they write. */
     void reset(unsigned seed);
 
     // *** Signals ***
@@ -108,7 +120,9 @@ public:
     /* Add an operator from an OpSpec object, which stores the type of operator
      * to add, as well as any parameters that operator needs (e.g. the Signals
      * that it operates on). Identifiies the type of operator that needs to
-     * be created, and calls the constructor appropriately. */
+     * be created, and calls the constructor appropriately. If
+     * config.signal_arena is set, the operator is only created by
+     * finalize_build, which moves its base signals to the arena as it goes. */
     void add_op(OpSpec os);
 
     /* Add an existing operator to the chunk. */
@@ -126,7 +140,9 @@ public:
 
     // *** Probes ***
 
-    // Add a a probe from a ProbeSpec object.
+    // Add a a probe from a ProbeSpec object. Like operators added from
+    // OpSpecs, probes are only created by finalize_build when using the
+    // signal arena.
     void add_probe(ProbeSpec ps);
 
     // *** Miscellaneous ***
@@ -134,6 +150,11 @@ public:
     void finalize_build();
     void finalize_build(MPI_Comm comm);
 
+    /* Free the windows made by create_windows, if any. Collective over the
+     * communicator given to finalize_build, so has to be called by all
+     * chunks, once they are done simulating. */
+    void free_windows();
+
     void set_log_filename(string lf);
     bool is_logging();
     void close_simulation_log();
@@ -165,9 +186,36 @@ private:
     unique_ptr<SimulationLog> sim_log;
     string log_filename;
 
+    // The base signals, which own the simulation data and keep the labels.
+    // Operators only hold SignalViews into them.
     map<key_type, Signal> signal_map;
+
+    // Copies of the base signals that operators write, restored by reset.
     map<key_type, Signal> signal_init_value;
 
+    // signal_map indexed by address; see index_signals.
+    SignalTable signal_table;
+
+    // Parameters of operators given as lists of values in their specs (e.g.
+    // the coefficients of a Synapse), which aren't base signals.
+    list<Signal> constant_signals;
+
+    // Operators and probes waiting for finalize_build to create them.
+    vector<OpSpec> pending_ops;
+    vector<ProbeSpec> pending_probes;
+
+    // Block holding the base signals, if config.signal_arena is set (see
+    // open_signal_arena), its size in dtypes and how much of it is in use.
+    shared_ptr<dtype> arena;
+    size_t arena_size;
+    size_t arena_used;
+
+    // While the arena is open, the base signals that have to keep their own
+    // buffers, and the keys of those that have been moved to the arena.
+    bool arena_open;
+    set<const dtype*> arena_pinned;
+    set<key_type> arena_placed;
+
     // Contains all operators - don't have to worry about deleting these, since we
     // have unique_ptr's for all these ops in the lists below.
     list<Operator*> operator_list;
@@ -180,7 +228,130 @@ private:
 
     unique_ptr<TimeUpdate> time_update;
 
+    // operator_list lowered into a flat program by finalize_build.
+    // Only used if config.use_plan is true.
+    ExecutionPlan plan;
+
+    // Only used if config.n_threads > 1.
+    unique_ptr<ParallelExecutor> executor;
+
+    // Windows through which MPIMessages are put, if config.transport is rma.
+    vector<MPI_Win> windows;
+
+    // Only used if config.transport is neighbor.
+    shared_ptr<NeighborExchange> exchange;
+
     bool collect_timings;
+    SimulatorConfig config;
+
+    /* Rebuild signal_table from signal_map. Has to be called again whenever
+     * base signals are added or moved. */
+    void index_signals();
+
+    /* Keep ``signal`` alive as long as the chunk, for operators that
+     * read it through a view. */
+    Signal add_constant_signal(Signal signal);
+
+    /* Fill signal_init_value with copies of the base signals that are
+     * written or incremented by some operator in operator_list. Signals that
+     * are only read (e.g. encoders and decoders) keep their values throughout
+     * the simulation, so they don't need a copy. */
+    void store_initial_values();
+
+    /* Create operators and probes from their specs. */
+    void build_op(OpSpec os);
+    void build_probe(ProbeSpec ps);
+
+    /* Allocate a single block of memory for the base signals. While it is
+     * open, get_signal and get_signal_view move a base signal into it (aligned
+     * to a cache line) the first time they are asked for it, so creating the
+     * pending operators in index order lays the bases out in the order in
+     * which the sorted operators first refer to them. Signals used by
+     * operators that were added already built (e.g. PyFuncs) keep their own
+     * buffers, since those operators point into them. */
+    void open_signal_arena();
+    void place_in_arena(key_type key);
+
+    /* Move the base signals that no operator or probe referred to into the
+     * arena, and stop moving signals. */
+    void close_signal_arena();
+
+    /* The extents written during a step, with the operator writing each,
+     * grouped by the base signal they belong to. */
+    typedef map<const dtype*, vector<pair<const Operator*, SignalExtent>>> WriteIndex;
+
+    /* Fill ``writes`` from the operator list. Returns false if some operator
+     * doesn't declare its accesses, in which case nothing can be assumed to
+     * be read-only. The DotInc replacements below write exactly what the
+     * DotIncs they replace did, so the index stays valid across them. */
+    bool index_writes(WriteIndex& writes) const;
+
+    /* An operator other than ``ignore`` that writes to memory overlapping
+     * ``extent``, or null if there is none. */
+    static const Operator* find_writer(
+        const WriteIndex& writes, const SignalExtent& extent,
+        const Operator* ignore=nullptr);
+
+    /* Replace DotIncs whose A is sparse and never written by SparseDotIncs
+     * (see config.sparse_threshold). */
+    void use_sparse_dot_incs(const WriteIndex& writes);
+
+    /* Replace matrix-vector DotIncs whose A is never written by
+     * CompressedDotIncs (see config.weight_precision), and print a report of
+     * the memory saved and the error introduced. */
+    void use_compressed_dot_incs(const WriteIndex& writes);
+
+    /* Replace each DotInc whose A is never written by ``convert(dot_inc)``,
+     * unless that returns null. Returns the number of DotIncs replaced. */
+    unsigned replace_read_only_dot_incs(
+        const WriteIndex& writes,
+        function<unique_ptr<Operator>(const DotInc&)> convert);
+
+    /* Replace matrix-vector DotIncs that read the output of a LIF or
+     * AdaptiveLIF operator by SpikeDotIncs, which only accumulate the columns
+     * of the neurons that spiked (see config.spike_events). */
+    void use_spike_dot_incs(const WriteIndex& writes);
+
+    /* Make all MPISends to the same destination that are in the same
+     * stretch of the (sorted) operator list between two MPIRecvs, and whose
+     * receivers agree on is_update, share a single MPIMessage, and do the
+     * same for the matching MPIRecvs. Moving the point at which a message is
+     * sent to its last member never makes it wait on a receive it didn't
+     * wait on before, so this can't cause deadlocks. Ranks exchange the
+     * information needed to agree on the messages, so all ranks in ``comm``
+     * must call this. */
+    void aggregate_messages(MPI_Comm comm);
+
+    /* Make the MPISends and MPIRecvs that aren't part of a message and have
+     * at least config.zero_copy_size values transfer straight from and to
+     * their content. The send of an MPISend may then be in flight until the
+     * next operator that writes its content, so an MPISendWait is placed
+     * right before that operator. An MPIRecv writes its content as the
+     * message arrives, so it can only do so if the content isn't probed,
+     * isn't written by anything else, and is only read after the MPIRecv in
+     * a step; its receives are then posted by an MPIRecvPost right after the
+     * last of these reads. Other MPIRecvs keep copying from a buffer. */
+    void transfer_in_place();
+
+    /* Give every MPIMessage (see config.transport) a pair of windows that
+     * expose the buffers of the receiving message on the destination, and
+     * that the sending message puts into. All ranks in ``comm`` must call
+     * this, since windows are created collectively. If more windows than
+     * config.max_windows would be needed on any rank, no windows are created
+     * on any of them and false is returned. */
+    bool create_windows(MPI_Comm comm);
+
+    /* Exchange the contents of all MPISends and MPIRecvs with neighborhood
+     * collectives on a distributed graph communicator whose edges are the
+     * pairs of chunks that communicate (see NeighborExchange and
+     * config.transport), and place the NeighborStarts and NeighborWaits of
+     * its rounds among the operators. All ranks in ``comm`` must call this,
+     * once the order of the operators is final. */
+    void create_neighbor_exchange(MPI_Comm comm);
+
+    /* Replace the operator at ``position`` in operator_list by ``op``,
+     * which takes over its index, and free the old operator. */
+    void replace_op(list<Operator*>::iterator position, unique_ptr<Operator> op);
 };
 
 template <class A, class B> inline bool compare_first_lt(const pair<A, B> &left, const pair<A, B> &right){
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// Storage format for the matrices of read-only DotIncs (see
+// SimulatorConfig::weight_precision and CompressedDotInc).
+enum WeightPrecision {
+    WEIGHTS_DOUBLE, WEIGHTS_FLOAT16, WEIGHTS_BFLOAT16, WEIGHTS_INT8
+};
+
+inline string weight_precision_name(WeightPrecision precision){
+    switch(precision){
+        case WEIGHTS_DOUBLE: return "double";
+        case WEIGHTS_FLOAT16: return "float16";
+        case WEIGHTS_BFLOAT16: return "bfloat16";
+        case WEIGHTS_INT8: return "int8";
+    }
+
+    return "unknown";
+}
+
+inline WeightPrecision weight_precision_from_string(const string& name){
+    for(WeightPrecision precision: {WEIGHTS_DOUBLE, WEIGHTS_FLOAT16, WEIGHTS_BFLOAT16, WEIGHTS_INT8}){
+        if(name == weight_precision_name(precision)){
+            return precision;
+        }
+    }
+
+    stringstream ss;
+    ss << "Unknown weight precision: " << name << ". "
+       << "Expected one of double, float16, bfloat16 or int8." << endl;
+    throw runtime_error(ss.str());
+}
+
+// How messages are transferred between chunks (see
+// SimulatorConfig::transport).
+enum Transport {
+    TRANSPORT_TWO_SIDED, TRANSPORT_RMA, TRANSPORT_NEIGHBOR
+};
+
+inline string transport_name(Transport transport){
+    switch(transport){
+        case TRANSPORT_TWO_SIDED: return "two-sided";
+        case TRANSPORT_RMA: return "rma";
+        case TRANSPORT_NEIGHBOR: return "neighbor";
+    }
+
+    return "unknown";
+}
+
+inline Transport transport_from_string(const string& name){
+    for(Transport transport: {TRANSPORT_TWO_SIDED, TRANSPORT_RMA, TRANSPORT_NEIGHBOR}){
+        if(name == transport_name(transport)){
+            return transport;
+        }
+    }
+
+    stringstream ss;
+    ss << "Unknown transport: " << name << ". "
+       << "Expected one of two-sided, rma or neighbor." << endl;
+    throw runtime_error(ss.str());
+}
+
+/* Runtime options controlling how a chunk is built and executed. These are
+ * set on the master (from the command line of nengo_mpi/nengo_cpp, or left
+ * at their defaults when running from python) and broadcast to the workers
+ * as raw bytes, so this struct must remain trivially copyable. */
+struct SimulatorConfig{
+
+    // Lower the sorted operator list into a flat ExecutionPlan at build time.
+    bool use_plan = true;
+
+    // Combine independent operators of the same type into batched operators.
+    bool merge_ops = true;
+
+    // Number of threads used to run each chunk's operators. With more than
+    // one, operators are run by a ParallelExecutor according to their
+    // dependency graph.
+    unsigned n_threads = 1;
+
+    // Reorder operators so that MPISends are posted as early as possible and
+    // operators waiting on MPIRecvs run as late as possible (see
+    // schedule_for_communication in op_graph.hpp).
+    bool schedule_comm = true;
+
+    // Send the contents of all MPISends from a chunk to the same destination
+    // that don't have an MPIRecv between them in a single message (see
+    // MpiSimulatorChunk::aggregate_messages).
+    bool aggregate_messages = true;
+
+    // Set up the requests of MPISends and MPIRecvs (or of their messages)
+    // once with MPI_Send_init/MPI_Recv_init, and only start them each step.
+    bool persistent_requests = true;
+
+    // MPISends and MPIRecvs of at least this many values aren't aggregated,
+    // and transfer straight from and to the memory of their signals instead
+    // of through a copy, where that is safe (see
+    // MpiSimulatorChunk::transfer_in_place). 0 disables this.
+    unsigned zero_copy_size = 1024;
+
+    // Transport for messages between chunks. two-sided uses
+    // MPI_Isend/MPI_Irecv. rma puts each message straight into a window
+    // exposing the receive buffer of the destination, synchronized with
+    // post-start-complete-wait epochs between the two chunks only (see
+    // MpiSimulatorChunk::create_windows). With rma, every MPISend and MPIRecv
+    // belongs to an MPIMessage. neighbor exchanges the messages of each
+    // round of a step with one MPI_Ineighbor_alltoallv on a distributed
+    // graph communicator (see MpiSimulatorChunk::create_neighbor_exchange),
+    // and ignores aggregate_messages. zero_copy_size and persistent_requests
+    // only apply to two-sided.
+    Transport transport = TRANSPORT_TWO_SIDED;
+    // With rma, the largest number of windows to create. Every window is
+    // created collectively and uses up one of the communicator contexts, of
+    // which MPI libraries only have a few thousand. Networks that would need
+    // more fall back to two-sided.
+    unsigned max_windows = 256;
+
+    // Hybrid MPI + threads mode: MPI is expected to have been initialized
+    // with MPI_THREAD_MULTIPLE, so MPI operators may run on any of the
+    // chunk's threads, and its worker threads are pinned to cores (see
+    // ParallelExecutor). Intended for running one process per node (or
+    // socket) with n_threads > 1.
+    bool hybrid = false;
+
+    // DotIncs whose A is never written and has a fraction of non-zero entries
+    // below this threshold are replaced by SparseDotIncs. 0 disables this.
+    float sparse_threshold = 0.1;
+
+    // DotIncs that multiply the output of spiking LIF neurons accumulate only
+    // the columns of the neurons that spiked in the step.
+    bool spike_events = true;
+
+    // Time the specialized small-matrix DotInc kernels against BLAS for each
+    // matrix shape at build time, and use whichever is faster.
+    bool autotune = false;
+
+    // Format used to store the matrices of DotIncs that are never written.
+    // Anything other than double replaces them by CompressedDotIncs, which
+    // use 2 (float16, bfloat16) or 1 (int8) bytes per entry but only
+    // approximate the original product. X and Y are still doubles.
+    WeightPrecision weight_precision = WEIGHTS_DOUBLE;
+
+    // Place all base signals in one aligned block of memory, in the order in
+    // which the sorted operators first touch them. Operators and probes
+    // specified as strings are then only created by finalize_build.
+    bool signal_arena = true;
+
+    // Ask for the signal arena to be backed by huge pages.
+    bool huge_pages = false;
+};
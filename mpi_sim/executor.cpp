@@ -0,0 +1,312 @@
+#include "executor.hpp"
+
+// Number of times an idle worker checks for a new step before going to sleep.
+#define EXECUTOR_SPIN_COUNT 1000
+
+ParallelExecutor::ParallelExecutor(unsigned n_threads, bool pin_threads, unsigned first_core)
+:n_threads(n_threads), first_core(first_core), plan(nullptr), n_edges(0), scratch_size(0), n_done(0), step_timings(nullptr),
+queues(new WorkQueue[n_threads]), generation(0), n_idle(0), shutdown(false){
+
+    if(n_threads == 0){
+        throw runtime_error("ParallelExecutor requires at least one thread.");
+    }
+
+#ifdef __linux__
+    if(pin_threads){
+        // Read the set of allowed cores before pinning anything, since
+        // threads inherit the affinity of the thread that creates them.
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) == 0){
+            for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+                if(CPU_ISSET(cpu, &allowed)){
+                    cores.push_back(cpu);
+                }
+            }
+        }
+    }
+#else
+    if(pin_threads){
+        cout << "Warning: pinning threads to cores is only supported on linux." << endl;
+    }
+#endif
+
+    for(unsigned i = 1; i < n_threads; i++){
+        workers.push_back(thread(&ParallelExecutor::worker_loop, this, i));
+    }
+}
+
+void ParallelExecutor::pin_thread(unsigned thread_index){
+#ifdef __linux__
+    if(cores.empty()){
+        return;
+    }
+
+    int core = cores[(first_core + thread_index) % cores.size()];
+
+    cpu_set_t cpu;
+    CPU_ZERO(&cpu);
+    CPU_SET(core, &cpu);
+
+    if(pthread_setaffinity_np(pthread_self(), sizeof(cpu), &cpu) != 0){
+        cout << "Warning: could not pin thread " << thread_index
+             << " to core " << core << "." << endl;
+    }
+#endif
+}
+
+ParallelExecutor::~ParallelExecutor(){
+    {
+        lock_guard<mutex> guard(wake_lock);
+        shutdown.store(true);
+    }
+    wake.notify_all();
+
+    for(auto& worker: workers){
+        worker.join();
+    }
+}
+
+void ParallelExecutor::compile(
+        const list<Operator*>& operator_list, const SignalTable& table, ExecutionPlan* p){
+    operators.assign(operator_list.begin(), operator_list.end());
+    plan = p;
+
+    if(plan && plan->size() != operators.size()){
+        stringstream msg;
+        msg << "ParallelExecutor: execution plan has " << plan->size()
+            << " records, but there are " << operators.size() << " operators.";
+        throw runtime_error(msg.str());
+    }
+
+    n_edges = build_dependency_graph(operators, table, successors, n_predecessors);
+
+    unsigned n_ops = operators.size();
+
+    // MPI operators still run in the order given. Otherwise a receive could
+    // wait before a send that it used to come after, and chunks that
+    // each wait for the other's send would deadlock.
+    int previous_mpi = -1;
+    for(unsigned i = 0; i < n_ops; i++){
+        string classname = operators[i]->classname();
+        if(classname != "MPISend" && classname != "MPIRecv" &&
+                classname != "MPISendWait" && classname != "MPIRecvPost" &&
+                classname != "NeighborStart" && classname != "NeighborWait"){
+            continue;
+        }
+
+        if(previous_mpi >= 0){
+            vector<unsigned>& next = successors[previous_mpi];
+            if(find(next.begin(), next.end(), i) == next.end()){
+                next.push_back(i);
+                n_predecessors[i]++;
+                n_edges++;
+            }
+        }
+
+        previous_mpi = i;
+    }
+
+    roots.clear();
+    pinned.assign(n_ops, false);
+    scratch_size = 0;
+    for(unsigned i = 0; i < n_ops; i++){
+        if(n_predecessors[i] == 0){
+            roots.push_back(i);
+        }
+
+        pinned[i] = operators[i]->requires_main_thread();
+        scratch_size = max(scratch_size, operators[i]->scratch_size());
+    }
+
+    remaining = unique_ptr<atomic<unsigned>[]>(new atomic<unsigned>[n_ops]);
+
+    build_dbg(*this);
+}
+
+void ParallelExecutor::run_step(double per_op_timings[]){
+    unsigned n_ops = operators.size();
+    if(n_ops == 0){
+        return;
+    }
+
+    step_timings = per_op_timings;
+
+    for(unsigned i = 0; i < n_ops; i++){
+        remaining[i].store(n_predecessors[i], memory_order_relaxed);
+    }
+
+    n_done.store(0, memory_order_relaxed);
+    n_idle.store(0, memory_order_relaxed);
+
+    // Spread the initially-ready operators over the threads.
+    for(unsigned i = 0; i < roots.size(); i++){
+        push(i % n_threads, roots[i]);
+    }
+
+    {
+        lock_guard<mutex> guard(wake_lock);
+        generation.fetch_add(1, memory_order_release);
+    }
+    wake.notify_all();
+
+    run_until_done(0);
+
+    // Make sure no worker is still looking at this step's state
+    // before the next step resets it.
+    while(n_idle.load(memory_order_acquire) < workers.size()){
+        this_thread::yield();
+    }
+
+    if(error){
+        exception_ptr e = error;
+        error = nullptr;
+        rethrow_exception(e);
+    }
+}
+
+void ParallelExecutor::worker_loop(unsigned thread_index){
+    pin_thread(thread_index);
+
+    unsigned seen = 0;
+
+    while(true){
+        unsigned spins = 0;
+        while(generation.load(memory_order_acquire) == seen && !shutdown.load()){
+            if(++spins < EXECUTOR_SPIN_COUNT){
+                this_thread::yield();
+            }else{
+                unique_lock<mutex> guard(wake_lock);
+                wake.wait(guard, [&]{
+                    return generation.load(memory_order_acquire) != seen || shutdown.load();
+                });
+            }
+        }
+
+        if(shutdown.load()){
+            return;
+        }
+
+        seen = generation.load(memory_order_acquire);
+
+        run_until_done(thread_index);
+
+        n_idle.fetch_add(1, memory_order_release);
+    }
+}
+
+void ParallelExecutor::run_until_done(unsigned thread_index){
+    unsigned n_ops = operators.size();
+    unsigned node;
+
+    scratch_space(scratch_size);
+
+    while(n_done.load(memory_order_acquire) < n_ops){
+        if(pop(thread_index, node)){
+            run_node(thread_index, node);
+        }else{
+            this_thread::yield();
+        }
+    }
+}
+
+bool ParallelExecutor::pop(unsigned thread_index, unsigned& node){
+    if(thread_index == 0){
+        lock_guard<mutex> guard(main_queue.lock);
+        if(!main_queue.nodes.empty()){
+            node = main_queue.nodes.front();
+            main_queue.nodes.pop_front();
+            return true;
+        }
+    }
+
+    // Most recently readied work from our own queue first...
+    {
+        WorkQueue& own = queues[thread_index];
+        lock_guard<mutex> guard(own.lock);
+        if(!own.nodes.empty()){
+            node = own.nodes.back();
+            own.nodes.pop_back();
+            return true;
+        }
+    }
+
+    // ...then the oldest work from everyone else's.
+    for(unsigned k = 1; k < n_threads; k++){
+        WorkQueue& other = queues[(thread_index + k) % n_threads];
+        lock_guard<mutex> guard(other.lock);
+        if(!other.nodes.empty()){
+            node = other.nodes.front();
+            other.nodes.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ParallelExecutor::push(unsigned thread_index, unsigned node){
+    WorkQueue& queue = pinned[node] ? main_queue : queues[thread_index];
+
+    lock_guard<mutex> guard(queue.lock);
+    queue.nodes.push_back(node);
+}
+
+void ParallelExecutor::run_node(unsigned thread_index, unsigned node){
+    try{
+        auto begin = chrono::steady_clock::now();
+
+        if(plan){
+            plan->run_record(node);
+        }else{
+            (*operators[node])();
+        }
+
+        if(step_timings){
+            auto end = chrono::steady_clock::now();
+            step_timings[node] += chrono::duration<double>(end - begin).count();
+        }
+    }catch(...){
+        lock_guard<mutex> guard(error_lock);
+        if(!error){
+            error = current_exception();
+        }
+    }
+
+    for(unsigned s: successors[node]){
+        if(remaining[s].fetch_sub(1, memory_order_acq_rel) == 1){
+            push(thread_index, s);
+        }
+    }
+
+    n_done.fetch_add(1, memory_order_release);
+}
+
+string ParallelExecutor::to_string() const{
+    unsigned n_ops = operators.size();
+
+    // Length, in operators, of the longest chain of dependencies.
+    vector<unsigned> depth(n_ops, 1);
+    unsigned critical_path = 0;
+    for(unsigned i = 0; i < n_ops; i++){
+        for(unsigned s: successors[i]){
+            depth[s] = max(depth[s], depth[i] + 1);
+        }
+        critical_path = max(critical_path, depth[i]);
+    }
+
+    unsigned n_pinned = count(pinned.begin(), pinned.end(), true);
+
+    stringstream out;
+    out << "<ParallelExecutor" << endl;
+    out << "n_threads: " << n_threads << endl;
+    out << "pinned_to_cores: " << !cores.empty() << endl;
+    out << "n_operators: " << n_ops << endl;
+    out << "n_edges: " << n_edges << endl;
+    out << "n_roots: " << roots.size() << endl;
+    out << "n_pinned: " << n_pinned << endl;
+    out << "critical_path: " << critical_path << endl;
+    out << ">" << endl;
+
+    return out.str();
+}
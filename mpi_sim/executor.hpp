@@ -0,0 +1,134 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iostream>
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+#include "operator.hpp"
+#include "plan.hpp"
+#include "op_graph.hpp"
+
+#include "debug.hpp"
+
+using namespace std;
+
+/* Runs the operators of a chunk on a pool of threads, respecting the
+ * dependency graph from build_dependency_graph, so the result of each step is
+ * exactly the same as running the operators in sequence. MPI operators are
+ * additionally kept in their original order with respect to each other.
+ *
+ * Each thread has its own queue of ready operators. When an operator
+ * finishes, the operators it was blocking are pushed onto the queue of the
+ * thread that ran it, so chains of dependent operators tend to stay on one
+ * core; idle threads steal from the other end of the other threads' queues.
+ * The thread calling run_step takes part as thread 0, and is the only thread
+ * that runs operators for which requires_main_thread() returns true (for
+ * MPI operators, that is the case unless MPI provides MPI_THREAD_MULTIPLE).
+ *
+ * Note that BLAS libraries often start their own threads; when using more
+ * than one thread here, the BLAS library should usually be limited to a
+ * single thread (e.g. OPENBLAS_NUM_THREADS=1). */
+class ParallelExecutor{
+public:
+    /* If ``pin_threads`` is true, worker thread i (for 0 < i < n_threads) is
+     * pinned to core ``first_core + i`` (modulo the number of cores) of those
+     * the process is allowed to run on. The thread calling run_step (thread
+     * 0) belongs to the caller, so it keeps its affinity. */
+    ParallelExecutor(unsigned n_threads, bool pin_threads=false, unsigned first_core=0);
+    ~ParallelExecutor();
+
+    ParallelExecutor(const ParallelExecutor&) = delete;
+    ParallelExecutor& operator= (const ParallelExecutor&) = delete;
+
+    /* ``operators`` must be in execution order, and ``table`` must index the
+     * base signals they access. If ``plan`` is non-null, it must have been
+     * compiled from ``operators``, and operators are run through its records
+     * instead of their virtual () operator. */
+    void compile(
+        const list<Operator*>& operators, const SignalTable& table,
+        ExecutionPlan* plan);
+
+    /* Run every operator once. If ``per_op_timings`` is non-null, the wall
+     * time spent in each operator is accumulated into it, indexed in the
+     * same order as the operators given to compile. Exceptions thrown by
+     * operators are rethrown here once the step has drained. */
+    void run_step(double per_op_timings[]=nullptr);
+
+    unsigned get_n_threads() const { return n_threads; }
+
+    string to_string() const;
+
+    friend ostream& operator << (ostream &out, const ParallelExecutor &executor){
+        out << executor.to_string();
+        return out;
+    }
+
+private:
+    struct WorkQueue{
+        mutex lock;
+        deque<unsigned> nodes;
+    };
+
+    void worker_loop(unsigned thread_index);
+    void pin_thread(unsigned thread_index);
+    void run_until_done(unsigned thread_index);
+
+    bool pop(unsigned thread_index, unsigned& node);
+    void push(unsigned thread_index, unsigned node);
+    void run_node(unsigned thread_index, unsigned node);
+
+    unsigned n_threads;
+
+    // Cores that threads are pinned to. Empty if threads are not pinned.
+    vector<int> cores;
+    unsigned first_core;
+
+    vector<Operator*> operators;
+    ExecutionPlan* plan;
+
+    vector<vector<unsigned>> successors;
+    vector<unsigned> n_predecessors;
+    vector<unsigned> roots;
+    vector<bool> pinned;
+    unsigned n_edges;
+
+    // Largest scratch_size() of any operator; each thread allocates its
+    // scratch space before running any of them.
+    size_t scratch_size;
+
+    // Per-step state.
+    unique_ptr<atomic<unsigned>[]> remaining;
+    atomic<unsigned> n_done;
+    double* step_timings;
+
+    exception_ptr error;
+    mutex error_lock;
+
+    // One queue per thread, plus one for operators pinned to the main thread.
+    unique_ptr<WorkQueue[]> queues;
+    WorkQueue main_queue;
+
+    // Workers sleep on ``wake`` between steps; run_step starts a
+    // step by incrementing ``generation``.
+    vector<thread> workers;
+    mutex wake_lock;
+    condition_variable wake;
+    atomic<unsigned> generation;
+    atomic<unsigned> n_idle;
+    atomic<bool> shutdown;
+};
@@ -1,31 +1,411 @@
 #include "mpi_operator.hpp"
 
-MPISend::MPISend(int dst, int tag, Signal content)
-:MPIOperator(tag), dst(dst), content(content){
+// Persistent requests have to be freed explicitly, which is only allowed
+// while MPI is still running.
+static void free_persistent_request(MPI_Request& request){
+    int finalized;
+    MPI_Finalized(&finalized);
 
-    if(!content.is_contiguous){
+    if(!finalized && request != MPI_REQUEST_NULL){
+        MPI_Request_free(&request);
+    }
+}
+
+MPIMessage::MPIMessage(int rank, int tag, int size, unsigned n_members, bool is_update)
+:rank(rank), tag(tag), buffer(size), n_members(n_members), is_update(is_update),
+n_done(0), first_call(true), persistent(false), request(MPI_REQUEST_NULL),
+rma(false), peer(MPI_GROUP_NULL), n_transferred(0), n_posted(0), n_expected(0){
+
+}
+
+MPIMessage::~MPIMessage(){
+    if(persistent){
+        free_persistent_request(request);
+    }
+
+    int finalized;
+    MPI_Finalized(&finalized);
+
+    if(!finalized && peer != MPI_GROUP_NULL){
+        MPI_Group_free(&peer);
+    }
+}
+
+void MPIMessage::use_windows(MPI_Win even, MPI_Win odd){
+    windows[0] = even;
+    windows[1] = odd;
+    rma = true;
+
+    MPI_Group group;
+    MPI_Comm_group(comm, &group);
+    MPI_Group_incl(group, 1, &rank, &peer);
+    MPI_Group_free(&group);
+}
+
+dtype* MPIMessage::window_buffer(unsigned parity){
+    if(parity == 0){
+        return buffer.raw_data;
+    }
+
+    if(!odd_buffer){
+        odd_buffer = unique_ptr<dtype[]>(new dtype[buffer.size]);
+    }
+
+    return odd_buffer.get();
+}
+
+void MPIMessage::make_persistent_send(){
+    MPI_Send_init(buffer.raw_data, buffer.size, MPI_DTYPE, rank, tag, comm, &request);
+    persistent = true;
+}
+
+void MPIMessage::make_persistent_recv(){
+    MPI_Recv_init(buffer.raw_data, buffer.size, MPI_DTYPE, rank, tag, comm, &request);
+    persistent = true;
+}
+
+void MPIMessage::pack(const dtype* data, int offset, int n){
+    if(n_done == 0 && !rma){
+        MPI_Wait(&request, &status);
+    }
+
+    memcpy(buffer.raw_data + offset, data, n * sizeof(dtype));
+
+    if(++n_done == n_members){
+        n_done = 0;
+
+        if(rma){
+            // Returns once the receiver has posted the epoch for this
+            // message, i.e. has unpacked the message before last.
+            MPI_Win window = windows[n_transferred % 2];
+            MPI_Win_start(peer, 0, window);
+            MPI_Put(
+                buffer.raw_data, buffer.size, MPI_DTYPE, rank,
+                0, buffer.size, MPI_DTYPE, window);
+            MPI_Win_complete(window);
+
+            n_transferred++;
+        }else if(persistent){
+            MPI_Start(&request);
+        }else{
+            MPI_Isend(buffer.raw_data, buffer.size, MPI_DTYPE, rank, tag, comm, &request);
+        }
+    }
+}
+
+double MPIMessage::unpack(dtype* data, int offset, int n){
+    // As for MPIRecv, updates are first received in the second step.
+    if(is_update && first_call){
+        if(++n_done == n_members){
+            n_done = 0;
+            first_call = false;
+        }
+
+        return 0.0;
+    }
+
+    double wait_time = 0.0;
+
+    unsigned parity = rma ? n_transferred % 2 : 0;
+
+    if(n_done == 0){
+        double wait_begin = MPI_Wtime();
+        if(rma){
+            MPI_Win_wait(windows[parity]);
+        }else{
+            MPI_Wait(&request, &status);
+        }
+        wait_time = MPI_Wtime() - wait_begin;
+    }
+
+    memcpy(data, window_buffer(parity) + offset, n * sizeof(dtype));
+
+    if(++n_done == n_members){
+        n_done = 0;
+
+        if(rma){
+            n_transferred++;
+        }
+
+        post();
+    }
+
+    return wait_time;
+}
+
+void MPIMessage::init(int n_steps){
+    if(!rma){
+        post();
+        return;
+    }
+
+    // The sender puts one message per step. Keep an epoch posted for the
+    // next two, and none beyond the end of the simulation, since they
+    // couldn't be closed.
+    n_expected = n_posted + n_steps;
+    post();
+    post();
+}
+
+void MPIMessage::post(){
+    if(rma){
+        if(n_posted < n_expected){
+            MPI_Win_post(peer, 0, windows[n_posted % 2]);
+            n_posted++;
+        }
+    }else if(persistent){
+        MPI_Start(&request);
+    }else{
+        MPI_Irecv(buffer.raw_data, buffer.size, MPI_DTYPE, rank, tag, comm, &request);
+    }
+}
+
+void MPIMessage::complete_send(){
+    if(!rma){
+        MPI_Wait(&request, &status);
+    }
+}
+
+void MPIMessage::complete_recv(){
+    if(rma){
+        // Only the last update of a simulation is still to be received.
+        while(n_transferred < n_posted){
+            MPI_Win_wait(windows[n_transferred % 2]);
+            n_transferred++;
+        }
+
+        return;
+    }
+
+    if(!is_update){
+        MPI_Cancel(&request);
+    }
+    MPI_Wait(&request, &status);
+}
+
+void MPIMessage::reset(){
+    n_done = 0;
+    first_call = true;
+}
+
+string MPIMessage::to_string() const{
+    stringstream out;
+
+    out << "MPIMessage:" << endl;
+    out << "rank: " << rank << endl;
+    out << "tag: " << tag << endl;
+    out << "size: " << buffer.size << endl;
+    out << "n_members: " << n_members << endl;
+    out << "is_update: " << is_update << endl;
+    out << "persistent: " << persistent << endl;
+    out << "rma: " << rma << endl;
+
+    return out.str();
+}
+
+// ********************************************************************************
+NeighborExchange::NeighborExchange(MPI_Comm graph_comm, unsigned n_rounds)
+:comm(graph_comm), rounds(n_rounds){
+
+}
+
+NeighborExchange::~NeighborExchange(){
+    int finalized;
+    MPI_Finalized(&finalized);
+
+    if(!finalized){
+        MPI_Comm_free(&comm);
+    }
+}
+
+void NeighborExchange::set_layout(
+        unsigned round, const vector<int>& send_counts, const vector<int>& recv_counts){
+
+    Round& r = rounds[round];
+    r.send_counts = send_counts;
+    r.recv_counts = recv_counts;
+
+    int n_send = 0;
+    for(int count: send_counts){
+        r.send_displs.push_back(n_send);
+        n_send += count;
+    }
+
+    int n_recv = 0;
+    for(int count: recv_counts){
+        r.recv_displs.push_back(n_recv);
+        n_recv += count;
+    }
+
+    r.send_buffer = Signal(n_send);
+    r.recv_buffer = Signal(n_recv);
+}
+
+void NeighborExchange::start(unsigned round){
+    Round& r = rounds[round];
+
+    MPI_Ineighbor_alltoallv(
+        r.send_buffer.raw_data, r.send_counts.data(), r.send_displs.data(), MPI_DTYPE,
+        r.recv_buffer.raw_data, r.recv_counts.data(), r.recv_displs.data(), MPI_DTYPE,
+        comm, &r.request);
+}
+
+void NeighborExchange::wait(unsigned round){
+    // The last round of the previous step has no request in the first step.
+    MPI_Wait(&rounds[round].request, MPI_STATUS_IGNORE);
+}
+
+void NeighborExchange::complete(){
+    for(auto& r: rounds){
+        MPI_Wait(&r.request, MPI_STATUS_IGNORE);
+    }
+}
+
+bool NeighborExchange::requires_main_thread() const{
+    int provided;
+    MPI_Query_thread(&provided);
+    return provided < MPI_THREAD_MULTIPLE;
+}
+
+string NeighborExchange::to_string() const{
+    stringstream out;
+
+    out << "NeighborExchange:" << endl;
+    out << "n_rounds: " << rounds.size() << endl;
+
+    for(unsigned i = 0; i < rounds.size(); i++){
+        out << "round " << i << ": sends " << rounds[i].send_buffer.size
+            << ", receives " << rounds[i].recv_buffer.size << endl;
+    }
+
+    return out.str();
+}
+
+// ********************************************************************************
+MPIOperator::~MPIOperator(){
+    if(persistent){
+        free_persistent_request(request);
+    }
+}
+
+// ********************************************************************************
+
+
+MPISend::MPISend(int dst, int tag, SignalView content)
+:MPIOperator(tag), dst(dst), content(content), in_place(false), offset(0), leader(false),
+round(0){
+
+    if(!content.is_contiguous()){
         throw runtime_error("MPISend got a non-contiguous signal.");
     }
 
-    content_data = content.raw_data;
-    size = content.size;
+    content_data = content.data;
+    size = content.size();
     buffer = unique_ptr<dtype>(new dtype[size]);
 }
 
 void MPISend::operator() (){
+    if(exchange){
+        memcpy(exchange->send_buffer(round).raw_data + offset, content_data, size * sizeof(dtype));
+
+        mpi_dbg(*this);
+        return;
+    }
+
+    if(message){
+        message->pack(content_data, offset, size);
+
+        mpi_dbg(*this);
+        return;
+    }
+
     if(first_call){
         first_call = false;
     }else{
         MPI_Wait(&request, &status);
     }
 
-    memcpy(buffer.get(), content_data, size * sizeof(dtype));
+    dtype* data = content_data;
+    if(!in_place){
+        data = buffer.get();
+        memcpy(data, content_data, size * sizeof(dtype));
+    }
 
-    MPI_Isend(buffer.get(), size, MPI_DOUBLE, dst, tag, comm, &request);
+    if(persistent){
+        MPI_Start(&request);
+    }else{
+        MPI_Isend(data, size, MPI_DTYPE, dst, tag, comm, &request);
+    }
 
     mpi_dbg(*this);
 }
 
+void MPISend::complete(){
+    // The chunk completes the exchange.
+    if(exchange){
+        return;
+    }
+
+    if(!message){
+        MPIOperator::complete();
+    }else if(leader){
+        message->complete_send();
+    }
+}
+
+void MPISend::reset(unsigned seed){
+    MPIOperator::reset(seed);
+
+    if(message){
+        message->reset();
+    }
+}
+
+void MPISend::make_persistent(){
+    if(!message){
+        dtype* data = in_place ? content_data : buffer.get();
+        MPI_Send_init(data, size, MPI_DTYPE, dst, tag, comm, &request);
+        persistent = true;
+    }else if(leader){
+        message->make_persistent_send();
+    }
+}
+
+void MPISend::send_in_place(){
+    in_place = true;
+    buffer.reset();
+}
+
+void MPISend::join_message(shared_ptr<MPIMessage> message, int offset, bool leader){
+    this->message = message;
+    this->offset = offset;
+    this->leader = leader;
+
+    buffer.reset();
+}
+
+void MPISend::join_exchange(shared_ptr<NeighborExchange> exchange, unsigned round, int offset){
+    this->exchange = exchange;
+    this->round = round;
+    this->offset = offset;
+
+    buffer.reset();
+}
+
+bool MPISend::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(content, ACCESS_READ));
+
+    if(exchange){
+        accesses.push_back(SignalAccess(exchange->send_buffer(round), ACCESS_UPDATE));
+    }
+
+    if(message){
+        accesses.push_back(SignalAccess(message->buffer, ACCESS_UPDATE));
+    }
+
+    return true;
+}
+
 string MPISend::to_string() const{
     stringstream out;
 
@@ -33,9 +413,20 @@ string MPISend::to_string() const{
     out << "tag: " << tag << endl;
     out << "dst: " << dst << endl;
     out << "size: " << size << endl;
+    out << "in_place: " << in_place << endl;
     out << "content:" << endl;
     out << signal_to_string(content) << endl;
 
+    if(message){
+        out << "offset: " << offset << endl;
+        out << message->to_string();
+    }
+
+    if(exchange){
+        out << "round: " << round << endl;
+        out << "offset: " << offset << endl;
+    }
+
     /*
     out << "buffer:" << endl;
     for(int i = 0; i < size; i++){
@@ -46,41 +437,159 @@ string MPISend::to_string() const{
     return out.str();
 }
 
-MPIRecv::MPIRecv(int src, int tag, Signal content, bool is_update)
-:MPIOperator(tag), src(src), content(content), is_update(is_update){
+MPIRecv::MPIRecv(int src, int tag, SignalView content, bool is_update)
+:MPIOperator(tag), src(src), content(content), is_update(is_update), in_place(false),
+wait_time(0.0), offset(0), leader(false), round(0){
 
-    if(!content.is_contiguous){
+    if(!content.is_contiguous()){
         throw runtime_error("MPIRecv got a non-contiguous signal.");
     }
 
-    content_data = content.raw_data;
-    size = content.size;
+    content_data = content.data;
+    size = content.size();
     buffer = unique_ptr<dtype>(new dtype[size]);
 }
 
 void MPIRecv::operator() (){
+    if(exchange){
+        // As with the other transports, updates are first received in the
+        // second step.
+        if(is_update && first_call){
+            first_call = false;
+        }else{
+            memcpy(
+                content_data, exchange->recv_buffer(round).raw_data + offset,
+                size * sizeof(dtype));
+        }
+
+        mpi_dbg(*this);
+        return;
+    }
+
+    if(message){
+        wait_time += message->unpack(content_data, offset, size);
+
+        mpi_dbg(*this);
+        return;
+    }
+
     if(is_update && first_call){
         first_call = false;
     }else{
+        double wait_begin = MPI_Wtime();
         MPI_Wait(&request, &status);
-        memcpy(content_data, buffer.get(), size * sizeof(dtype));
-        MPI_Irecv(buffer.get(), size, MPI_DOUBLE, src, tag, comm, &request);
+        wait_time += MPI_Wtime() - wait_begin;
+
+        if(!in_place){
+            memcpy(content_data, buffer.get(), size * sizeof(dtype));
+            post();
+        }
     }
 
     mpi_dbg(*this);
 }
 
-void MPIRecv::init(){
-    MPI_Irecv(buffer.get(), size, MPI_DOUBLE, src, tag, comm, &request);
+void MPIRecv::init(int n_steps){
+    wait_time = 0.0;
+
+    // Rounds of an exchange are started by NeighborStarts.
+    if(exchange){
+        return;
+    }
+
+    if(message){
+        if(leader){
+            message->init(n_steps);
+        }
+
+    // An update is only received at the start of the next step, so the
+    // content has to keep its initial value for the first step, and the
+    // MPIRecvPost posts the first receive.
+    }else if(!(in_place && is_update)){
+        post();
+    }
+}
+
+void MPIRecv::post(){
+    if(persistent){
+        MPI_Start(&request);
+    }else{
+        dtype* data = in_place ? content_data : buffer.get();
+        MPI_Irecv(data, size, MPI_DTYPE, src, tag, comm, &request);
+    }
 }
 
 void MPIRecv::complete(){
+    if(exchange){
+        return;
+    }
+
+    if(message){
+        if(leader){
+            message->complete_recv();
+        }
+        return;
+    }
+
     if(!is_update){
         MPI_Cancel(&request);
     }
     MPI_Wait(&request, &status);
 }
 
+void MPIRecv::reset(unsigned seed){
+    MPIOperator::reset(seed);
+
+    if(message){
+        message->reset();
+    }
+}
+
+void MPIRecv::make_persistent(){
+    if(!message){
+        dtype* data = in_place ? content_data : buffer.get();
+        MPI_Recv_init(data, size, MPI_DTYPE, src, tag, comm, &request);
+        persistent = true;
+    }else if(leader){
+        message->make_persistent_recv();
+    }
+}
+
+void MPIRecv::receive_in_place(){
+    in_place = true;
+    buffer.reset();
+}
+
+void MPIRecv::join_message(shared_ptr<MPIMessage> message, int offset, bool leader){
+    this->message = message;
+    this->offset = offset;
+    this->leader = leader;
+
+    buffer.reset();
+}
+
+void MPIRecv::join_exchange(shared_ptr<NeighborExchange> exchange, unsigned round, int offset){
+    this->exchange = exchange;
+    this->round = round;
+    this->offset = offset;
+
+    buffer.reset();
+}
+
+bool MPIRecv::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(content, ACCESS_SET));
+
+    if(exchange){
+        accesses.push_back(SignalAccess(exchange->recv_buffer(round), ACCESS_READ));
+    }
+
+    if(message){
+        accesses.push_back(SignalAccess(message->buffer, ACCESS_UPDATE));
+    }
+
+    return true;
+}
+
 string MPIRecv::to_string() const{
     stringstream out;
 
@@ -89,9 +598,20 @@ string MPIRecv::to_string() const{
     out << "src: " << src << endl;
     out << "size: " << size << endl;
     out << "is_update: " << is_update << endl;
+    out << "in_place: " << in_place << endl;
     out << "content:" << endl;
     out << signal_to_string(content) << endl;
 
+    if(message){
+        out << "offset: " << offset << endl;
+        out << message->to_string();
+    }
+
+    if(exchange){
+        out << "round: " << round << endl;
+        out << "offset: " << offset << endl;
+    }
+
     /*
     out << "buffer:" << endl;
     for(int i = 0; i < size; i++){
@@ -101,3 +621,24 @@ string MPIRecv::to_string() const{
 
     return out.str();
 }
+
+// ********************************************************************************
+bool MPISendWait::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(send->get_content(), ACCESS_READ));
+    return true;
+}
+
+bool MPIRecvPost::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(recv->get_content(), ACCESS_SET));
+    return true;
+}
+
+bool NeighborStart::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(exchange->send_buffer(round), ACCESS_READ));
+    return true;
+}
+
+bool NeighborWait::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(exchange->recv_buffer(round), ACCESS_SET));
+    return true;
+}
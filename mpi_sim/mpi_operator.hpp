@@ -11,11 +11,154 @@
 
 using namespace std;
 
+/* A single MPI message that carries the contents of several MPISends from a
+ * chunk to the same destination, or of several MPIRecvs from the same source
+ * (see MpiSimulatorChunk::aggregate_messages). Each member still packs or
+ * unpacks its own content at its own position in the step. The first member
+ * to run in a step waits for the previous message, and the last one posts the
+ * next message, so the members must run one at a time (which they ensure by
+ * all declaring an update of ``buffer``).
+ *
+ * With the rma transport (see use_windows), the message is instead put
+ * straight into ``buffer`` on the receiving chunk, or into a second buffer
+ * for every other message, so that the sender can put the next message
+ * before the receiver has unpacked the previous one, just as it can send it
+ * before the receive is posted with MPI_Isend. */
+class MPIMessage{
+
+public:
+    MPIMessage(int rank, int tag, int size, unsigned n_members, bool is_update);
+    ~MPIMessage();
+
+    void set_communicator(MPI_Comm comm){ this->comm = comm; }
+
+    // Set up a persistent request for sending or receiving the message; see
+    // MPIOperator::make_persistent.
+    void make_persistent_send();
+    void make_persistent_recv();
+
+    // Copy ``n`` values from ``data`` into the message at ``offset``. Posts
+    // the message once all members have packed their contents.
+    void pack(const dtype* data, int offset, int n);
+
+    // Copy ``n`` values at ``offset`` in the message to ``data``. Returns the
+    // time spent waiting for the message.
+    double unpack(dtype* data, int offset, int n);
+
+    // Post the first receive(s) of a simulation of ``n_steps`` steps.
+    void init(int n_steps);
+
+    // Transfer the message with MPI_Put into the windows of the receiving
+    // chunk rather than with MPI_Isend/MPI_Irecv. Messages are put into
+    // ``even`` and ``odd`` in turn. ``even`` and ``odd`` must expose
+    // window_buffer(0) and window_buffer(1) of the receiving message.
+    void use_windows(MPI_Win even, MPI_Win odd);
+
+    // The buffer that messages are received into in the window used for
+    // the given parity.
+    dtype* window_buffer(unsigned parity);
+
+    // Wait for the last message of a simulation to be sent, or to arrive
+    // (an update) or be cancelled (otherwise).
+    void complete_send();
+    void complete_recv();
+
+    void reset();
+
+    string to_string() const;
+
+    // The rank of the destination or the source, and the tag of the
+    // message (the smallest tag of its members).
+    const int rank;
+    const int tag;
+
+    Signal buffer;
+
+private:
+    const unsigned n_members;
+    const bool is_update;
+
+    // Number of members that have run in the current step.
+    unsigned n_done;
+    bool first_call;
+    bool persistent;
+
+    MPI_Comm comm;
+    MPI_Request request;
+    MPI_Status status;
+
+    // Only used with use_windows. The number of messages put or received
+    // so far, and on the receiving side, the number of epochs posted so far
+    // and the number that will have been posted at the end of the current
+    // simulation.
+    bool rma;
+    MPI_Win windows[2];
+    MPI_Group peer;
+    unique_ptr<dtype[]> odd_buffer;
+    unsigned n_transferred;
+    unsigned n_posted;
+    unsigned n_expected;
+
+    // Post the next receive (two-sided) or exposure epoch (rma).
+    void post();
+};
+
+/* The messages between chunks, when they are exchanged with neighborhood
+ * collectives (see MpiSimulatorChunk::create_neighbor_exchange). The
+ * messages of a step are split into rounds. In each round, a chunk sends the
+ * contents that its MPISends of the round have packed into the send buffer
+ * to all of its neighbors in a distributed graph communicator with a single
+ * MPI_Ineighbor_alltoallv, and its MPIRecvs of the round unpack their
+ * contents from the receive buffer. Rounds are started by NeighborStarts and
+ * completed by NeighborWaits placed among the operators. All chunks in the
+ * communicator have to start the same rounds in the same order. */
+class NeighborExchange{
+
+public:
+    NeighborExchange(MPI_Comm graph_comm, unsigned n_rounds);
+    ~NeighborExchange();
+
+    // Lay out ``round``: the number of values sent to each destination and
+    // received from each source, in the order the neighbors were given to
+    // the graph communicator, packed one after the other.
+    void set_layout(
+        unsigned round, const vector<int>& send_counts, const vector<int>& recv_counts);
+
+    void start(unsigned round);
+    void wait(unsigned round);
+
+    // Wait for the rounds still in flight at the end of a simulation.
+    void complete();
+
+    Signal& send_buffer(unsigned round){ return rounds[round].send_buffer; }
+    Signal& recv_buffer(unsigned round){ return rounds[round].recv_buffer; }
+    unsigned n_rounds() const { return rounds.size(); }
+
+    bool requires_main_thread() const;
+
+    string to_string() const;
+
+private:
+    struct Round{
+        Signal send_buffer;
+        Signal recv_buffer;
+
+        vector<int> send_counts, send_displs;
+        vector<int> recv_counts, recv_displs;
+
+        MPI_Request request = MPI_REQUEST_NULL;
+    };
+
+    MPI_Comm comm;
+    vector<Round> rounds;
+};
+
 class MPIOperator: public Operator{
 
 public:
-    MPIOperator():first_call(true){}
-    MPIOperator(int tag):first_call(true), tag(tag){}
+    MPIOperator():first_call(true), persistent(false), request(MPI_REQUEST_NULL){}
+    MPIOperator(int tag):first_call(true), persistent(false), tag(tag), request(MPI_REQUEST_NULL){}
+    virtual ~MPIOperator();
 
     string classname() const { return "MPIOperator"; }
 
@@ -24,11 +167,26 @@ public:
 
     virtual void reset(unsigned seed){first_call = true;}
 
+    // MPI calls may only be made from other threads if MPI
+    // was initialized with MPI_THREAD_MULTIPLE.
+    bool requires_main_thread() const{
+        int provided;
+        MPI_Query_thread(&provided);
+        return provided < MPI_THREAD_MULTIPLE;
+    }
+
     virtual void complete(){ MPI_Wait(&request, &status); }
     void set_communicator(MPI_Comm comm){ this->comm = comm; }
 
+    // Set up a persistent request (MPI_Send_init/MPI_Recv_init) once, so that
+    // each step only has to start it, rather than having MPI match and set
+    // up a new request with the same buffer, peer, tag and size. Must be
+    // called after set_communicator and joining a message, if any.
+    virtual void make_persistent() = 0;
+
 protected:
     bool first_call;
+    bool persistent;
 
     int tag;
     MPI_Comm comm;
@@ -42,32 +200,180 @@ protected:
 class MPISend: public MPIOperator{
 
 public:
-    MPISend(int dst, int tag, Signal content);
+    MPISend(int dst, int tag, SignalView content);
     string classname() const { return "MPISend"; }
 
     virtual void operator()();
+    virtual void complete();
+    virtual void reset(unsigned seed);
+    virtual void make_persistent();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+    int get_dst() const { return dst; }
+    int get_tag() const { return tag; }
+    int get_size() const { return size; }
+    SignalView get_content() const { return content; }
+
+    // Send the content as part of ``message``, at ``offset``, instead of in a
+    // message of its own. ``leader`` is true for exactly one member of the
+    // message, which completes it at the end of a simulation.
+    void join_message(shared_ptr<MPIMessage> message, int offset, bool leader);
+    bool is_in_message() const { return bool(message); }
+    shared_ptr<MPIMessage> get_message() const { return message; }
+
+    // Pack the content into the send buffer of ``round`` of ``exchange`` at
+    // ``offset``, instead of sending it.
+    void join_exchange(shared_ptr<NeighborExchange> exchange, unsigned round, int offset);
+
+    // Send straight from the content instead of copying it to a buffer
+    // first. The content must then not be written until the send has
+    // completed; see MPISendWait. Must be called before make_persistent.
+    void send_in_place();
+
+    // Wait for the most recent send to complete.
+    void wait(){ MPI_Wait(&request, &status); }
 
 private:
     int dst;
-    Signal content;
+    SignalView content;
     dtype* content_data;
+    bool in_place;
+
+    shared_ptr<MPIMessage> message;
+    int offset;
+    bool leader;
+
+    shared_ptr<NeighborExchange> exchange;
+    unsigned round;
 };
 
 class MPIRecv: public MPIOperator{
 
 public:
-    MPIRecv(int src, int tag, Signal content, bool is_update);
+    MPIRecv(int src, int tag, SignalView content, bool is_update);
     string classname() const { return "MPIRecv"; }
 
     virtual void operator()();
-    void init();
+
+    // Post the first receive of a simulation of ``n_steps`` steps.
+    void init(int n_steps);
+
     virtual void complete();
+    virtual void reset(unsigned seed);
+    virtual void make_persistent();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+    // Total seconds spent blocked in MPI_Wait since the last call to init.
+    double get_wait_time() const { return wait_time; }
+
+    int get_src() const { return src; }
+    int get_tag() const { return tag; }
+    int get_size() const { return size; }
+    bool get_is_update() const { return is_update; }
+    SignalView get_content() const { return content; }
+
+    // Receive the content as part of ``message``; see MPISend::join_message.
+    void join_message(shared_ptr<MPIMessage> message, int offset, bool leader);
+    bool is_in_message() const { return bool(message); }
+    shared_ptr<MPIMessage> get_message() const { return message; }
+
+    // Unpack the content from the receive buffer of ``round`` of
+    // ``exchange``; see MPISend::join_exchange.
+    void join_exchange(shared_ptr<NeighborExchange> exchange, unsigned round, int offset);
+
+    // Receive straight into the content instead of into a buffer that is
+    // then copied to the content. Receives are then posted by an MPIRecvPost
+    // placed after the last operator that reads the content in a step,
+    // rather than by the MPIRecv itself. Must be called before
+    // make_persistent.
+    void receive_in_place();
+
+    // Post the next receive.
+    void post();
 
 private:
     int src;
-    Signal content;
+    SignalView content;
     dtype* content_data;
     bool is_update;
+    bool in_place;
+
+    double wait_time;
+
+    shared_ptr<MPIMessage> message;
+    int offset;
+    bool leader;
+
+    shared_ptr<NeighborExchange> exchange;
+    unsigned round;
+};
+
+/* Completes the send of an MPISend that sends in place, right before the
+ * operator that next writes the content of the MPISend. */
+class MPISendWait: public Operator{
+
+public:
+    MPISendWait(MPISend* send):send(send){}
+    string classname() const { return "MPISendWait"; }
+
+    void operator()(){ send->wait(); }
+    bool requires_main_thread() const { return send->requires_main_thread(); }
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+private:
+    MPISend* send;
+};
+
+/* Posts the next receive of an MPIRecv that receives in place, once the
+ * operators that read the content of the MPIRecv in a step have run. */
+class MPIRecvPost: public Operator{
+
+public:
+    MPIRecvPost(MPIRecv* recv):recv(recv){}
+    string classname() const { return "MPIRecvPost"; }
+
+    void operator()(){ recv->post(); }
+    bool requires_main_thread() const { return recv->requires_main_thread(); }
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+private:
+    MPIRecv* recv;
+};
+
+/* Starts a round of a NeighborExchange, once the MPISends of the round have
+ * packed their contents. */
+class NeighborStart: public Operator{
+
+public:
+    NeighborStart(shared_ptr<NeighborExchange> exchange, unsigned round)
+    :exchange(exchange), round(round){}
+    string classname() const { return "NeighborStart"; }
+
+    void operator()(){ exchange->start(round); }
+    bool requires_main_thread() const { return exchange->requires_main_thread(); }
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+private:
+    shared_ptr<NeighborExchange> exchange;
+    unsigned round;
+};
+
+/* Completes a round of a NeighborExchange, before the MPIRecvs of the round
+ * unpack their contents. */
+class NeighborWait: public Operator{
+
+public:
+    NeighborWait(shared_ptr<NeighborExchange> exchange, unsigned round)
+    :exchange(exchange), round(round){}
+    string classname() const { return "NeighborWait"; }
+
+    void operator()(){ exchange->wait(round); }
+    bool requires_main_thread() const { return exchange->requires_main_thread(); }
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+private:
+    shared_ptr<NeighborExchange> exchange;
+    unsigned round;
 };
@@ -3,8 +3,8 @@
 int n_processors_available = 1;
 
 // This constructor assumes that MPI_Initialize has already been called.
-MpiSimulator::MpiSimulator(bool collect_timings)
-:Simulator(collect_timings), comm(MPI_COMM_WORLD){
+MpiSimulator::MpiSimulator(bool collect_timings, SimulatorConfig config)
+:Simulator(collect_timings, config), comm(MPI_COMM_WORLD){
     MPI_Comm_size(comm, &n_processors);
 
     int buflen = 512;
@@ -18,11 +18,26 @@ MpiSimulator::MpiSimulator(bool collect_timings)
     cout << "Master rank in merged communicator: " << rank << " (should be 0)." << endl;
     cout << "Master detected " << n_processors << " processor(s) in total." << endl;
 
+    if(config.hybrid){
+        int provided;
+        MPI_Query_thread(&provided);
+
+        if(provided < MPI_THREAD_MULTIPLE){
+            cout << "Warning: hybrid mode requested, but MPI does not provide "
+                 << "MPI_THREAD_MULTIPLE. MPI operators will only be run "
+                 << "by each chunk's main thread." << endl;
+        }
+
+        cout << "Running in hybrid mode with " << config.n_threads
+             << " thread(s) per process." << endl;
+    }
+
     mpi_wake_workers();
     bcast_send_int(collect_timings ? 1 : 0, comm);
+    bcast_send_config(config, comm);
 
     chunk = unique_ptr<MpiSimulatorChunk>(
-        new MpiSimulatorChunk(0, n_processors, collect_timings));
+        new MpiSimulatorChunk(0, n_processors, collect_timings, config));
 }
 
 MpiSimulator::~MpiSimulator(){
@@ -170,6 +185,7 @@ void MpiSimulator::close(){
     MPI_Bcast(&steps, 1, MPI_INT, 0, comm);
 
     chunk->close_simulation_log();
+    chunk->free_windows();
 
     // Master barrier 4
     MPI_Barrier(comm);
@@ -204,11 +220,16 @@ void MpiSimulator::write_to_time_file(char* filename, double delta){
     }
 }
 
-void mpi_init(){
+void mpi_init(bool thread_multiple){
     int argc = 0;
     char** argv;
 
-    MPI_Init(&argc, &argv);
+    if(thread_multiple){
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    }else{
+        MPI_Init(&argc, &argv);
+    }
 
     MPI_Comm_size(MPI_COMM_WORLD, &n_processors_available);
 }
@@ -272,11 +293,14 @@ void mpi_worker_start(MPI_Comm comm){
         dbg("Reading collect_timings...");
         int collect_timings = bcast_recv_int(comm);
 
+        dbg("Reading config...");
+        SimulatorConfig config = bcast_recv_config(comm);
+
         dbg("Reading filename...");
         string filename = recv_string(0, setup_tag, comm);
 
         dbg("Creating chunk...");
-        MpiSimulatorChunk chunk(rank, n_processors, bool(collect_timings));
+        MpiSimulatorChunk chunk(rank, n_processors, bool(collect_timings), config);
 
         // Use parallel property lists
         hid_t file_plist = H5Pcreate(H5P_FILE_ACCESS);
@@ -346,6 +370,7 @@ void mpi_worker_start(MPI_Comm comm){
                 dbg("Worker " << rank << " received the signal to close the simulation." << endl);
 
                 chunk.close_simulation_log();
+                chunk.free_windows();
 
                 // Worker barrier 4
                 MPI_Barrier(comm);
@@ -387,14 +412,14 @@ void send_string(string s, int dst, int tag, MPI_Comm comm){
 
 dtype recv_dtype(int src, int tag, MPI_Comm comm){
     MPI_Status status;
-    double d;
+    dtype d;
 
-    MPI_Recv(&d, 1, MPI_DOUBLE, src, tag, comm, &status);
+    MPI_Recv(&d, 1, MPI_DTYPE, src, tag, comm, &status);
     return d;
 }
 
 void send_dtype(dtype d, int dst, int tag, MPI_Comm comm){
-    MPI_Send(&d, 1, MPI_DOUBLE, dst, tag, comm);
+    MPI_Send(&d, 1, MPI_DTYPE, dst, tag, comm);
 }
 
 int recv_int(int src, int tag, MPI_Comm comm){
@@ -441,7 +466,7 @@ Signal recv_base_signal(int src, int tag, MPI_Comm comm){
     unsigned size2 = recv_unsigned(src, tag, comm);
 
     Signal signal = Signal(size1, size2);
-    MPI_Recv(signal.raw_data, signal.size, MPI_DOUBLE, src, tag, comm, &status);
+    MPI_Recv(signal.raw_data, signal.size, MPI_DTYPE, src, tag, comm, &status);
 
     return signal;
 }
@@ -451,7 +476,7 @@ void send_base_signal(Signal signal, int dst, int tag, MPI_Comm comm){
     send_unsigned(signal.shape1, dst, tag, comm);
     send_unsigned(signal.shape2, dst, tag, comm);
 
-    MPI_Send(signal.raw_data, signal.size, MPI_DOUBLE, dst, tag, comm);
+    MPI_Send(signal.raw_data, signal.size, MPI_DTYPE, dst, tag, comm);
 }
 
 int bcast_recv_int(MPI_Comm comm){
@@ -480,4 +505,18 @@ void bcast_send_unsigned(unsigned i, MPI_Comm comm){
     int src = 0;
 
     MPI_Bcast(&i, 1, MPI_UNSIGNED, src, comm);
-}
\ No newline at end of file
+}
+
+SimulatorConfig bcast_recv_config(MPI_Comm comm){
+    int src = 0;
+
+    SimulatorConfig config;
+    MPI_Bcast(&config, sizeof(SimulatorConfig), MPI_BYTE, src, comm);
+    return config;
+}
+
+void bcast_send_config(SimulatorConfig config, MPI_Comm comm){
+    int src = 0;
+
+    MPI_Bcast(&config, sizeof(SimulatorConfig), MPI_BYTE, src, comm);
+}
@@ -12,6 +12,7 @@
 #include "spec.hpp"
 #include "chunk.hpp"
 #include "psim_log.hpp"
+#include "config.hpp"
 
 #include "typedef.hpp"
 #include "debug.hpp"
@@ -26,7 +27,7 @@ extern int n_processors_available;
 
 class MpiSimulator: public Simulator{
 public:
-    MpiSimulator(bool collect_timings);
+    MpiSimulator(bool collect_timings, SimulatorConfig config=SimulatorConfig());
     ~MpiSimulator();
 
     void from_file(string filename) override;
@@ -57,7 +58,9 @@ protected:
     vector<int> probe_counts;
 };
 
-void mpi_init();
+// If ``thread_multiple`` is true, request MPI_THREAD_MULTIPLE
+// so that the simulator can be run in hybrid mode.
+void mpi_init(bool thread_multiple=false);
 void mpi_finalize();
 int mpi_get_rank();
 int mpi_get_n_procs();
@@ -89,3 +92,6 @@ void bcast_send_int(int i, MPI_Comm comm);
 
 unsigned bcast_recv_unsigned(MPI_Comm comm);
 void bcast_send_unsigned(unsigned i, MPI_Comm comm);
+
+SimulatorConfig bcast_recv_config(MPI_Comm comm);
+void bcast_send_config(SimulatorConfig config, MPI_Comm comm);
@@ -7,7 +7,7 @@
 #include "simulator.hpp"
 
 
-enum serialOptionIndex {UNKNOWN, HELP, NO_PROG, TIMING, LOG, SEED};
+enum serialOptionIndex {UNKNOWN, HELP, NO_PROG, TIMING, LOG, SEED, NO_PLAN, NO_MERGE, NO_SCHEDULE, THREADS, SPARSE, NO_EVENTS, AUTOTUNE, WEIGHTS, NO_ARENA, HUGE_PAGES};
 
 const option::Descriptor serial_usage[] =
 {
@@ -24,6 +24,35 @@ const option::Descriptor serial_usage[] =
                                                                "If not specified, the log filename is the same as the "
                                                                "name of the network file, but with the .h5 extension."},
  {SEED,     0, "",  "seed",     option::Arg::Numeric, "  --seed  \tSeed for stochastic processes in the network."},
+ {NO_PLAN,  0, "",  "noplan",   option::Arg::None, "  --noplan  \tSupply to run operators through virtual calls "
+                                                   "instead of a compiled execution plan."},
+ {NO_MERGE, 0, "",  "nomerge",  option::Arg::None, "  --nomerge  \tSupply to disable merging operators of the same "
+                                                   "type into batched operators."},
+ {NO_SCHEDULE, 0, "", "noschedule", option::Arg::None, "  --noschedule  \tSupply to keep operators in the order given "
+                                                         "by the network file, instead of posting MPI sends early "
+                                                         "and waiting on MPI receives late."},
+ {THREADS,  0, "",  "threads",  option::Arg::Numeric, "  --threads  \tNumber of threads used to run the operators "
+                                                      "of each chunk (default 1). When using more than one, "
+                                                      "the BLAS library should be limited to one thread "
+                                                      "(e.g. OPENBLAS_NUM_THREADS=1)."},
+ {SPARSE,   0, "",  "sparse",   option::Arg::NonEmpty, "  --sparse  \tDotIncs whose matrix is never written and has "
+                                                       "a smaller fraction of non-zero entries than this are run "
+                                                       "as sparse matrix products (default 0.1, 0 to disable)."},
+ {NO_EVENTS, 0, "", "noevents", option::Arg::None, "  --noevents  \tSupply to compute products with the output of "
+                                                     "spiking neurons densely, instead of only over "
+                                                     "the neurons that spiked."},
+ {AUTOTUNE, 0, "",  "autotune", option::Arg::None, "  --autotune  \tSupply to time the specialized kernels for small "
+                                                    "matrices against BLAS for each matrix shape in the "
+                                                    "network, and use whichever is faster."},
+ {WEIGHTS,  0, "",  "weights",  option::Arg::NonEmpty, "  --weights  \tFormat used to store the matrices of products "
+                                                       "whose matrix is never written: double (default), "
+                                                       "float16, bfloat16 or int8. Anything but double saves "
+                                                       "memory, but only approximates the products."},
+ {NO_ARENA, 0, "", "noarena", option::Arg::None, "  --noarena  \tSupply to leave each signal in its own buffer, "
+                                                   "instead of placing all signals in one block of memory "
+                                                   "in the order the operators use them."},
+ {HUGE_PAGES, 0, "", "hugepages", option::Arg::None, "  --hugepages  \tSupply to ask for the block of memory holding "
+                                                     "the signals to be backed by huge pages."},
  {UNKNOWN,  0, "" , ""   ,      option::Arg::None, "\nExamples:\n"
                                                    "  nengo_cpp --progress basal_ganglia.net 1.0\n"
                                                    "  nengo_cpp --log ~/spaun_results.h5 spaun.net 7.5\n" },
@@ -90,10 +119,47 @@ int main(int argc, char **argv){
     }
 
     cout << "Will simulate with seed: " << seed << endl;
+
+    SimulatorConfig config;
+    config.use_plan = !bool(options[NO_PLAN]);
+    cout << "Use execution plan: " << config.use_plan << endl;
+
+    config.merge_ops = !bool(options[NO_MERGE]);
+    cout << "Merge operators: " << config.merge_ops << endl;
+
+    config.schedule_comm = !bool(options[NO_SCHEDULE]);
+    cout << "Schedule for communication: " << config.schedule_comm << endl;
+
+    if(options[THREADS]){
+        config.n_threads = boost::lexical_cast<unsigned>(options[THREADS].arg);
+    }
+    cout << "Threads per chunk: " << config.n_threads << endl;
+
+    if(options[SPARSE]){
+        config.sparse_threshold = boost::lexical_cast<float>(options[SPARSE].arg);
+    }
+    cout << "Sparse DotInc threshold: " << config.sparse_threshold << endl;
+
+    config.spike_events = !bool(options[NO_EVENTS]);
+    cout << "Event-driven spike products: " << config.spike_events << endl;
+
+    config.autotune = bool(options[AUTOTUNE]);
+    cout << "Autotune small-matrix kernels: " << config.autotune << endl;
+
+    if(options[WEIGHTS]){
+        config.weight_precision = weight_precision_from_string(options[WEIGHTS].arg);
+    }
+    cout << "Weight precision: " << weight_precision_name(config.weight_precision) << endl;
+
+    config.signal_arena = !bool(options[NO_ARENA]);
+    cout << "Signal arena: " << config.signal_arena << endl;
+
+    config.huge_pages = bool(options[HUGE_PAGES]);
+    cout << "Huge pages for signal arena: " << config.huge_pages << endl;
     cout << endl;
 
     cout << "Building network..." << endl;
-    auto sim = unique_ptr<Simulator>(new Simulator(collect_timings));
+    auto sim = unique_ptr<Simulator>(new Simulator(collect_timings, config));
     sim->from_file(net_filename);
     sim->finalize_build();
 
@@ -12,7 +12,7 @@
 
 using namespace std;
 
-enum serialOptionIndex {UNKNOWN, HELP, NO_PROG, TIMING, LOG, SEED};
+enum serialOptionIndex {UNKNOWN, HELP, NO_PROG, TIMING, LOG, SEED, NO_PLAN, NO_MERGE, NO_SCHEDULE, THREADS, HYBRID, SPARSE, NO_EVENTS, AUTOTUNE, WEIGHTS, NO_ARENA, HUGE_PAGES, NO_AGGREGATE, NO_PERSISTENT, ZERO_COPY, TRANSPORT, MAX_WINDOWS};
 
 const option::Descriptor serial_usage[] =
 {
@@ -29,9 +29,60 @@ const option::Descriptor serial_usage[] =
                                                                "If not specified, the log filename is the same as the "
                                                                "name of the network file, but with the .h5 extension."},
  {SEED,     0, "",  "seed",     option::Arg::Numeric, "  --seed  \tSeed for stochastic processes in the network."},
+ {NO_PLAN,  0, "",  "noplan",   option::Arg::None, "  --noplan  \tSupply to run operators through virtual calls "
+                                                   "instead of a compiled execution plan."},
+ {NO_MERGE, 0, "",  "nomerge",  option::Arg::None, "  --nomerge  \tSupply to disable merging operators of the same "
+                                                   "type into batched operators."},
+ {NO_SCHEDULE, 0, "", "noschedule", option::Arg::None, "  --noschedule  \tSupply to keep operators in the order given "
+                                                         "by the network file, instead of posting MPI sends early "
+                                                         "and waiting on MPI receives late."},
+ {THREADS,  0, "",  "threads",  option::Arg::Numeric, "  --threads  \tNumber of threads used to run the operators "
+                                                      "of each chunk (default 1). When using more than one, "
+                                                      "the BLAS library should be limited to one thread "
+                                                      "(e.g. OPENBLAS_NUM_THREADS=1)."},
+ {HYBRID,   0, "",  "hybrid",   option::Arg::None, "  --hybrid  \tSupply to initialize MPI with MPI_THREAD_MULTIPLE, "
+                                                   "so that MPI operators can be run by any of a process's "
+                                                   "threads, and pin worker threads to cores. Intended for running one "
+                                                   "process per node with --threads."},
+ {SPARSE,   0, "",  "sparse",   option::Arg::NonEmpty, "  --sparse  \tDotIncs whose matrix is never written and has "
+                                                       "a smaller fraction of non-zero entries than this are run "
+                                                       "as sparse matrix products (default 0.1, 0 to disable)."},
+ {NO_EVENTS, 0, "", "noevents", option::Arg::None, "  --noevents  \tSupply to compute products with the output of "
+                                                     "spiking neurons densely, instead of only over "
+                                                     "the neurons that spiked."},
+ {AUTOTUNE, 0, "",  "autotune", option::Arg::None, "  --autotune  \tSupply to time the specialized kernels for small "
+                                                    "matrices against BLAS for each matrix shape in the "
+                                                    "network, and use whichever is faster."},
+ {WEIGHTS,  0, "",  "weights",  option::Arg::NonEmpty, "  --weights  \tFormat used to store the matrices of products "
+                                                       "whose matrix is never written: double (default), "
+                                                       "float16, bfloat16 or int8. Anything but double saves "
+                                                       "memory, but only approximates the products."},
+ {NO_ARENA, 0, "", "noarena", option::Arg::None, "  --noarena  \tSupply to leave each signal in its own buffer, "
+                                                   "instead of placing all signals in one block of memory "
+                                                   "in the order the operators use them."},
+ {HUGE_PAGES, 0, "", "hugepages", option::Arg::None, "  --hugepages  \tSupply to ask for the block of memory holding "
+                                                     "the signals to be backed by huge pages."},
+ {NO_AGGREGATE, 0, "", "noaggregate", option::Arg::None, "  --noaggregate  \tSupply to send each connection between "
+                                                         "chunks as a message of its own, instead of combining "
+                                                         "the messages to each neighbouring chunk."},
+ {NO_PERSISTENT, 0, "", "nopersistent", option::Arg::None, "  --nopersistent  \tSupply to post a new MPI request for "
+                                                           "every message in every step, instead of setting up "
+                                                           "persistent requests once."},
+ {ZERO_COPY, 0, "", "zerocopy", option::Arg::NonEmpty, "  --zerocopy  \tMessages between chunks with at least this "
+                                                       "many values are sent and received straight from and to "
+                                                       "signal memory where possible (default 1024, 0 to disable)."},
+ {TRANSPORT, 0, "", "transport", option::Arg::NonEmpty, "  --transport  \tHow messages between chunks are transferred. "
+                                                        "One of two-sided (MPI_Isend/MPI_Irecv, the default), rma "
+                                                        "(MPI_Put into windows, synchronized between neighbors "
+                                                        "only) or neighbor (one neighborhood collective per round "
+                                                        "of messages)."},
+ {MAX_WINDOWS, 0, "", "maxwindows", option::Arg::NonEmpty, "  --maxwindows  \tWith --transport=rma, the largest number "
+                                                           "of MPI windows to create (default 256). Networks that "
+                                                           "would need more use two-sided messages instead."},
  {UNKNOWN,  0, "" , ""   ,      option::Arg::None, "\nExamples:\n"
                                                    "  nengo_mpi --noprog basal_ganglia.net 1.0\n"
-                                                   "  nengo_mpi --log ~/spaun_results.h5 spaun.net 7.5\n" },
+                                                   "  nengo_mpi --log ~/spaun_results.h5 spaun.net 7.5\n"
+                                                   "  mpirun -npernode 1 nengo_mpi --hybrid --threads 16 spaun.net 7.5\n" },
  {0,0,0,0,0,0}
 };
 
@@ -96,10 +147,71 @@ int mpi_master_start(int argc, char **argv){
         seed = boost::lexical_cast<unsigned>(options[SEED].arg);
     }
     cout << "Will simulate with seed: " << seed << endl;
+
+    SimulatorConfig config;
+    config.use_plan = !bool(options[NO_PLAN]);
+    cout << "Use execution plan: " << config.use_plan << endl;
+
+    config.merge_ops = !bool(options[NO_MERGE]);
+    cout << "Merge operators: " << config.merge_ops << endl;
+
+    config.schedule_comm = !bool(options[NO_SCHEDULE]);
+    cout << "Schedule for communication: " << config.schedule_comm << endl;
+
+    config.aggregate_messages = !bool(options[NO_AGGREGATE]);
+    cout << "Aggregate messages: " << config.aggregate_messages << endl;
+
+    config.persistent_requests = !bool(options[NO_PERSISTENT]);
+    cout << "Persistent requests: " << config.persistent_requests << endl;
+
+    if(options[ZERO_COPY]){
+        config.zero_copy_size = boost::lexical_cast<unsigned>(options[ZERO_COPY].arg);
+    }
+    cout << "Zero-copy message size: " << config.zero_copy_size << endl;
+
+    if(options[TRANSPORT]){
+        config.transport = transport_from_string(options[TRANSPORT].arg);
+    }
+    cout << "Transport: " << transport_name(config.transport) << endl;
+
+    if(options[MAX_WINDOWS]){
+        config.max_windows = boost::lexical_cast<unsigned>(options[MAX_WINDOWS].arg);
+    }
+    cout << "Maximum number of windows: " << config.max_windows << endl;
+
+    if(options[THREADS]){
+        config.n_threads = boost::lexical_cast<unsigned>(options[THREADS].arg);
+    }
+    cout << "Threads per chunk: " << config.n_threads << endl;
+
+    if(options[SPARSE]){
+        config.sparse_threshold = boost::lexical_cast<float>(options[SPARSE].arg);
+    }
+    cout << "Sparse DotInc threshold: " << config.sparse_threshold << endl;
+
+    config.spike_events = !bool(options[NO_EVENTS]);
+    cout << "Event-driven spike products: " << config.spike_events << endl;
+
+    config.autotune = bool(options[AUTOTUNE]);
+    cout << "Autotune small-matrix kernels: " << config.autotune << endl;
+
+    if(options[WEIGHTS]){
+        config.weight_precision = weight_precision_from_string(options[WEIGHTS].arg);
+    }
+    cout << "Weight precision: " << weight_precision_name(config.weight_precision) << endl;
+
+    config.signal_arena = !bool(options[NO_ARENA]);
+    cout << "Signal arena: " << config.signal_arena << endl;
+
+    config.huge_pages = bool(options[HUGE_PAGES]);
+    cout << "Huge pages for signal arena: " << config.huge_pages << endl;
+
+    config.hybrid = bool(options[HYBRID]);
+    cout << "Hybrid MPI + threads mode: " << config.hybrid << endl;
     cout << endl;
 
     cout << "Building network..." << endl;
-    auto sim = unique_ptr<MpiSimulator>(new MpiSimulator(collect_timings));
+    auto sim = unique_ptr<MpiSimulator>(new MpiSimulator(collect_timings, config));
     sim->from_file(net_filename);
     sim->finalize_build();
 
@@ -122,7 +234,21 @@ int mpi_master_start(int argc, char **argv){
 
 int main(int argc, char **argv){
 
-    MPI_Init(&argc, &argv);
+    // The thread level has to be chosen before MPI is initialized, and
+    // hence before the options are parsed on the master.
+    bool hybrid = false;
+    for(int i = 1; i < argc; i++){
+        if(string(argv[i]) == "--hybrid"){
+            hybrid = true;
+        }
+    }
+
+    if(hybrid){
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    }else{
+        MPI_Init(&argc, &argv);
+    }
 
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
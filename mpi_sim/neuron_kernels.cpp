@@ -0,0 +1,235 @@
+#include "neuron_kernels.hpp"
+
+// The arithmetic below mirrors the original implementation of LIF::operator():
+//
+//     dV = (J - voltage) * scale
+//     voltage += dV
+//     voltage = max(voltage, min_voltage)
+//     ref_time -= dt
+//     mult = clip(ref_time * -dt_inv + 1, 0, 1)
+//     voltage *= mult
+//     spiked: output = dt_inv, ref_time = tau_ref + dt * (1 - (voltage - 1) / dV), voltage = 0
+//     otherwise: output = 0
+//
+// and of AdaptiveLIF::operator(), which additionally used J - adaptation as the
+// input current and then updated adaptation += dt_tau_n * (output * inc_n - adaptation).
+
+template<bool Adaptive>
+static inline void lif_scalar(
+        const LIFParams& p, const AdaptationParams* a, unsigned n,
+        const dtype* J, int J_stride, dtype* output, int output_stride,
+        dtype* voltage, int voltage_stride, dtype* ref_time, int ref_time_stride,
+        dtype* adaptation, int adaptation_stride){
+
+    for(int i = 0; i < int(n); ++i){
+        dtype j = J[i * J_stride];
+        if(Adaptive){
+            j = j - adaptation[i * adaptation_stride];
+        }
+
+        dtype& v = voltage[i * voltage_stride];
+        dtype& r = ref_time[i * ref_time_stride];
+
+        dtype dV = (j - v) * p.scale;
+
+        v = v + dV;
+        v = v < p.min_voltage ? p.min_voltage : v;
+
+        r = r - p.dt;
+
+        dtype m = r * -p.dt_inv;
+        m = m + 1.0;
+        m = m > 1.0 ? 1.0 : (m < 0.0 ? 0.0 : m);
+
+        v = v * m;
+
+        dtype out;
+        if(v > 1.0){
+            out = p.dt_inv;
+            dtype overshoot = (v - 1.0) / dV;
+            r = p.tau_ref + p.dt * (1.0 - overshoot);
+            v = 0.0;
+        }else{
+            out = 0.0;
+        }
+
+        output[i * output_stride] = out;
+
+        if(Adaptive){
+            dtype& adapt = adaptation[i * adaptation_stride];
+            dtype dAdapt = out * a->inc_n;
+            dAdapt = dAdapt - adapt;
+            adapt = adapt + a->dt_tau_n * dAdapt;
+        }
+    }
+}
+
+#ifdef LIF_KERNELS_SIMD
+
+// Thin wrappers so the vector kernel can be written once for both
+// instruction sets. ``select(m, a, b)`` takes b where m is set, a elsewhere.
+// max(a, b) is (a > b ? a : b) and min(a, b) is (a < b ? a : b), exactly as
+// in the scalar code, including for NaNs.
+
+#if defined(__AVX512F__)
+struct SimdOps{
+    typedef __m512d V;
+    typedef __mmask8 M;
+    static const int width = 8;
+
+    static V load(const dtype* p){ return _mm512_loadu_pd(p); }
+    static void store(dtype* p, V a){ _mm512_storeu_pd(p, a); }
+    static V set1(dtype a){ return _mm512_set1_pd(a); }
+
+    static V add(V a, V b){ return _mm512_add_pd(a, b); }
+    static V sub(V a, V b){ return _mm512_sub_pd(a, b); }
+    static V mul(V a, V b){ return _mm512_mul_pd(a, b); }
+    static V div(V a, V b){ return _mm512_div_pd(a, b); }
+    static V max(V a, V b){ return _mm512_max_pd(a, b); }
+    static V min(V a, V b){ return _mm512_min_pd(a, b); }
+
+    static M gt(V a, V b){ return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static V select(M m, V a, V b){ return _mm512_mask_blend_pd(m, a, b); }
+};
+#else
+struct SimdOps{
+    typedef __m256d V;
+    typedef __m256d M;
+    static const int width = 4;
+
+    static V load(const dtype* p){ return _mm256_loadu_pd(p); }
+    static void store(dtype* p, V a){ _mm256_storeu_pd(p, a); }
+    static V set1(dtype a){ return _mm256_set1_pd(a); }
+
+    static V add(V a, V b){ return _mm256_add_pd(a, b); }
+    static V sub(V a, V b){ return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b){ return _mm256_mul_pd(a, b); }
+    static V div(V a, V b){ return _mm256_div_pd(a, b); }
+    static V max(V a, V b){ return _mm256_max_pd(a, b); }
+    static V min(V a, V b){ return _mm256_min_pd(a, b); }
+
+    static M gt(V a, V b){ return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static V select(M m, V a, V b){ return _mm256_blendv_pd(a, b, m); }
+};
+#endif
+
+// Processes neurons in whole vectors, for contiguous arrays only.
+// Returns the number of neurons processed.
+template<bool Adaptive>
+static inline unsigned lif_simd(
+        const LIFParams& p, const AdaptationParams* a, unsigned n,
+        const dtype* J, dtype* output, dtype* voltage, dtype* ref_time,
+        dtype* adaptation){
+
+    typedef SimdOps S;
+    typedef S::V V;
+
+    const V scale = S::set1(p.scale);
+    const V min_voltage = S::set1(p.min_voltage);
+    const V dt = S::set1(p.dt);
+    const V dt_inv = S::set1(p.dt_inv);
+    const V neg_dt_inv = S::set1(-p.dt_inv);
+    const V tau_ref = S::set1(p.tau_ref);
+    const V one = S::set1(1.0);
+    const V zero = S::set1(0.0);
+
+    const V inc_n = S::set1(Adaptive ? a->inc_n : 0.0);
+    const V dt_tau_n = S::set1(Adaptive ? a->dt_tau_n : 0.0);
+
+    unsigned n_vec = n - n % S::width;
+
+    for(unsigned i = 0; i < n_vec; i += S::width){
+        V j = S::load(J + i);
+        if(Adaptive){
+            j = S::sub(j, S::load(adaptation + i));
+        }
+
+        V v = S::load(voltage + i);
+        V r = S::load(ref_time + i);
+
+        V dV = S::mul(S::sub(j, v), scale);
+
+        v = S::add(v, dV);
+        v = S::max(min_voltage, v);
+
+        r = S::sub(r, dt);
+
+        V m = S::add(S::mul(r, neg_dt_inv), one);
+        m = S::min(one, S::max(zero, m));
+
+        v = S::mul(v, m);
+
+        S::M spiked = S::gt(v, one);
+
+        V overshoot = S::div(S::sub(v, one), dV);
+        V spike_ref_time = S::add(tau_ref, S::mul(dt, S::sub(one, overshoot)));
+
+        V out = S::select(spiked, zero, dt_inv);
+
+        S::store(output + i, out);
+        S::store(voltage + i, S::select(spiked, v, zero));
+        S::store(ref_time + i, S::select(spiked, r, spike_ref_time));
+
+        if(Adaptive){
+            V adapt = S::load(adaptation + i);
+            V dAdapt = S::sub(S::mul(out, inc_n), adapt);
+            S::store(adaptation + i, S::add(adapt, S::mul(dt_tau_n, dAdapt)));
+        }
+    }
+
+    return n_vec;
+}
+
+#endif
+
+template<bool Adaptive>
+static inline void lif_dispatch(
+        const LIFParams& p, const AdaptationParams* a, unsigned n,
+        const dtype* J, int J_stride, dtype* output, int output_stride,
+        dtype* voltage, int voltage_stride, dtype* ref_time, int ref_time_stride,
+        dtype* adaptation, int adaptation_stride){
+
+    unsigned done = 0;
+
+#ifdef LIF_KERNELS_SIMD
+    bool contiguous =
+        J_stride == 1 && output_stride == 1 && voltage_stride == 1 &&
+        ref_time_stride == 1 && (!Adaptive || adaptation_stride == 1);
+
+    if(contiguous){
+        done = lif_simd<Adaptive>(p, a, n, J, output, voltage, ref_time, adaptation);
+    }
+#endif
+
+    if(done < n){
+        int k = int(done);
+        lif_scalar<Adaptive>(
+            p, a, n - done,
+            J + k * J_stride, J_stride, output + k * output_stride, output_stride,
+            voltage + k * voltage_stride, voltage_stride,
+            ref_time + k * ref_time_stride, ref_time_stride,
+            Adaptive ? adaptation + k * adaptation_stride : nullptr, adaptation_stride);
+    }
+}
+
+void lif_kernel(
+        const LIFParams& p, unsigned n,
+        const dtype* J, int J_stride, dtype* output, int output_stride,
+        dtype* voltage, int voltage_stride, dtype* ref_time, int ref_time_stride){
+
+    lif_dispatch<false>(
+        p, nullptr, n, J, J_stride, output, output_stride,
+        voltage, voltage_stride, ref_time, ref_time_stride, nullptr, 0);
+}
+
+void adaptive_lif_kernel(
+        const LIFParams& p, const AdaptationParams& a, unsigned n,
+        const dtype* J, int J_stride, dtype* output, int output_stride,
+        dtype* voltage, int voltage_stride, dtype* ref_time, int ref_time_stride,
+        dtype* adaptation, int adaptation_stride){
+
+    lif_dispatch<true>(
+        p, &a, n, J, J_stride, output, output_stride,
+        voltage, voltage_stride, ref_time, ref_time_stride,
+        adaptation, adaptation_stride);
+}
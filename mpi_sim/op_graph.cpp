@@ -0,0 +1,308 @@
+#include "op_graph.hpp"
+#include "batched_operator.hpp"
+
+SignalExtent::SignalExtent(const SignalView& signal, const SignalTable& table)
+:base(table.base_of(signal.data)){
+
+    if(signal.size() == 0){
+        first = 1;
+        last = 0;
+        return;
+    }
+
+    long span1 = long(signal.shape1 - 1) * signal.stride1;
+    long span2 = long(signal.shape2 - 1) * signal.stride2;
+
+    first = uintptr_t(signal.data + min(span1, 0L) + min(span2, 0L));
+    last = uintptr_t(signal.data + max(span1, 0L) + max(span2, 0L));
+}
+
+int AccessTracker::latest_in(
+        const map<const dtype*, vector<Record>>& records, const SignalExtent& extent) const{
+
+    int latest = -1;
+
+    auto it = records.find(extent.base);
+    if(it != records.end()){
+        for(const Record& r: it->second){
+            if(r.position > latest && r.extent.overlaps(extent)){
+                latest = r.position;
+            }
+        }
+    }
+
+    return latest;
+}
+
+int AccessTracker::latest_conflict(const vector<SignalAccess>& accesses) const{
+    int latest = last_barrier;
+
+    for(const SignalAccess& access: accesses){
+        SignalExtent extent(access.signal, table);
+
+        latest = max(latest, latest_in(writes, extent));
+
+        if(access.type != ACCESS_READ){
+            latest = max(latest, latest_in(reads, extent));
+        }
+    }
+
+    return latest;
+}
+
+void AccessTracker::all_in(
+        const map<const dtype*, vector<Record>>& records, const SignalExtent& extent,
+        vector<int>& positions) const{
+
+    auto it = records.find(extent.base);
+    if(it != records.end()){
+        for(const Record& r: it->second){
+            if(r.extent.overlaps(extent)){
+                positions.push_back(r.position);
+            }
+        }
+    }
+}
+
+void AccessTracker::conflicts(
+        const vector<SignalAccess>& accesses, vector<int>& positions) const{
+
+    if(last_barrier >= 0){
+        positions.push_back(last_barrier);
+    }
+
+    for(const SignalAccess& access: accesses){
+        SignalExtent extent(access.signal, table);
+
+        all_in(writes, extent, positions);
+
+        if(access.type != ACCESS_READ){
+            all_in(reads, extent, positions);
+        }
+    }
+}
+
+void AccessTracker::record(const vector<SignalAccess>& accesses, int position){
+    for(const SignalAccess& access: accesses){
+        SignalExtent extent(access.signal, table);
+        auto& records = access.type == ACCESS_READ ? reads : writes;
+        records[extent.base].push_back({extent, position});
+    }
+
+    last_position = max(last_position, position);
+}
+
+void AccessTracker::record_barrier(int position){
+    last_barrier = max(last_barrier, position);
+    last_position = max(last_position, position);
+}
+
+list<Operator*> merge_operators(
+        const list<Operator*>& operators, list<unique_ptr<Operator>>& store,
+        const SignalTable& table){
+
+    vector<Operator*> ops(operators.begin(), operators.end());
+    unsigned n_ops = ops.size();
+
+    // For each operator, the position of the first member of its group.
+    // Operators that are not in a group are their own group.
+    vector<int> group_of(n_ops);
+    map<int, vector<Operator*>> groups;
+
+    // The most recently created group for each merge key.
+    map<string, int> open_group;
+
+    AccessTracker tracker(table);
+
+    for(unsigned position = 0; position < n_ops; position++){
+        Operator* op = ops[position];
+        group_of[position] = position;
+
+        vector<SignalAccess> accesses;
+        if(!op->get_accesses(accesses)){
+            tracker.record_barrier(position);
+            continue;
+        }
+
+        string key = op->merge_key();
+
+        if(key.size() > 0){
+            int latest = tracker.latest_conflict(accesses);
+
+            auto it = open_group.find(key);
+            if(it != open_group.end() && it->second > latest){
+                group_of[position] = it->second;
+            }else{
+                open_group[key] = position;
+            }
+
+            groups[group_of[position]].push_back(op);
+        }
+
+        tracker.record(accesses, group_of[position]);
+    }
+
+    list<Operator*> merged;
+    unsigned n_batched = 0;
+
+    for(unsigned position = 0; position < n_ops; position++){
+        if(group_of[position] != (int) position){
+            continue;
+        }
+
+        auto it = groups.find(position);
+        if(it == groups.end() || it->second.size() == 1){
+            merged.push_back(ops[position]);
+            continue;
+        }
+
+        unique_ptr<Operator> batched = make_batched_operator(it->second);
+        batched->set_index(ops[position]->get_index());
+
+        build_dbg("Merged " << it->second.size() << " operators into: " << *batched);
+
+        merged.push_back(batched.get());
+        store.push_back(move(batched));
+
+        n_batched += it->second.size();
+    }
+
+    build_dbg(
+        "Merging reduced " << n_ops << " operators to " << merged.size()
+        << "; " << n_batched << " were batched.");
+
+    return merged;
+}
+
+unsigned build_dependency_graph(
+        const vector<Operator*>& operators, const SignalTable& table,
+        vector<vector<unsigned>>& successors, vector<unsigned>& n_predecessors){
+
+    unsigned n_ops = operators.size();
+    successors.assign(n_ops, vector<unsigned>());
+    n_predecessors.assign(n_ops, 0);
+
+    AccessTracker tracker(table);
+    unsigned n_edges = 0;
+
+    // Start of the operators that come after the most recent barrier.
+    unsigned segment_start = 0;
+
+    for(unsigned position = 0; position < n_ops; position++){
+        vector<int> predecessors;
+        vector<SignalAccess> accesses;
+
+        bool declared = operators[position]->get_accesses(accesses);
+
+        if(declared){
+            tracker.conflicts(accesses, predecessors);
+            tracker.record(accesses, position);
+        }else{
+            // Everything since the previous barrier (which all
+            // depend on that barrier themselves).
+            for(unsigned p = segment_start > 0 ? segment_start - 1 : 0; p < position; p++){
+                predecessors.push_back(p);
+            }
+
+            tracker.record_barrier(position);
+            segment_start = position + 1;
+        }
+
+        sort(predecessors.begin(), predecessors.end());
+        auto last = unique(predecessors.begin(), predecessors.end());
+
+        for(auto it = predecessors.begin(); it != last; ++it){
+            successors[*it].push_back(position);
+            n_predecessors[position]++;
+            n_edges++;
+        }
+    }
+
+    return n_edges;
+}
+
+list<Operator*> schedule_for_communication(
+        const list<Operator*>& operator_list, const SignalTable& table){
+    vector<Operator*> operators(operator_list.begin(), operator_list.end());
+    unsigned n_ops = operators.size();
+
+    vector<vector<unsigned>> successors;
+    vector<unsigned> n_predecessors;
+    build_dependency_graph(operators, table, successors, n_predecessors);
+
+    vector<vector<unsigned>> predecessors(n_ops);
+    for(unsigned i = 0; i < n_ops; i++){
+        for(unsigned s: successors[i]){
+            predecessors[s].push_back(i);
+        }
+    }
+
+    // Edges always go forward, so one pass in each direction
+    // is enough to propagate reachability.
+    vector<bool> feeds_send(n_ops, false);
+    for(int i = int(n_ops) - 1; i >= 0; i--){
+        if(operators[i]->classname() == "MPISend"){
+            feeds_send[i] = true;
+        }
+
+        if(feeds_send[i]){
+            for(unsigned p: predecessors[i]){
+                feeds_send[p] = true;
+            }
+        }
+    }
+
+    vector<bool> needs_recv(n_ops, false);
+    for(unsigned i = 0; i < n_ops; i++){
+        if(operators[i]->classname() == "MPIRecv"){
+            needs_recv[i] = true;
+        }
+
+        if(needs_recv[i]){
+            for(unsigned s: successors[i]){
+                needs_recv[s] = true;
+            }
+        }
+    }
+
+    // Smaller is scheduled earlier. An operator that both depends on a
+    // receive and feeds a send is on the critical path, so it goes early.
+    auto priority = [&](unsigned i){
+        return feeds_send[i] ? 0 : (needs_recv[i] ? 2 : 1);
+    };
+
+    auto later = [&](unsigned a, unsigned b){
+        int pa = priority(a), pb = priority(b);
+        return pa != pb ? pa > pb : a > b;
+    };
+
+    priority_queue<unsigned, vector<unsigned>, function<bool(unsigned, unsigned)>> ready(later);
+    for(unsigned i = 0; i < n_ops; i++){
+        if(n_predecessors[i] == 0){
+            ready.push(i);
+        }
+    }
+
+    list<Operator*> scheduled;
+    unsigned n_moved = 0;
+
+    while(!ready.empty()){
+        unsigned i = ready.top();
+        ready.pop();
+
+        n_moved += (i != scheduled.size());
+        scheduled.push_back(operators[i]);
+
+        for(unsigned s: successors[i]){
+            if(--n_predecessors[s] == 0){
+                ready.push(s);
+            }
+        }
+    }
+
+    build_dbg(
+        "Scheduling for communication moved " << n_moved << " of "
+        << n_ops << " operators.");
+
+    return scheduled;
+}
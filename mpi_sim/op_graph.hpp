@@ -0,0 +1,115 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <vector>
+#include <memory>
+#include <string>
+#include <queue>
+#include <functional>
+
+#include "signal.hpp"
+#include "operator.hpp"
+
+#include "typedef.hpp"
+#include "debug.hpp"
+
+using namespace std;
+
+/* The memory that a view can touch, as a closed interval of addresses,
+ * along with the start of the base signal it lies in (looked up in
+ * ``table``; null if it isn't part of any base signal there). This is
+ * conservative: strided views cover the whole interval between their first
+ * and last elements. */
+struct SignalExtent{
+    SignalExtent(const SignalView& signal, const SignalTable& table);
+
+    const dtype* base;
+    uintptr_t first;
+    uintptr_t last;
+
+    bool overlaps(const SignalExtent& other) const{
+        return base == other.base && first <= other.last && other.first <= last;
+    }
+};
+
+/* Records the signal accesses of a sequence of operators, each tagged with the
+ * position the operator will execute at, and answers which recorded operators
+ * a new operator must stay behind. Two accesses conflict if they touch
+ * overlapping memory and at least one of them is not a read. Incs conflict
+ * with each other too, since reordering them changes the rounding of the
+ * result. Operators that don't declare their accesses are recorded as
+ * barriers, which conflict with everything. Signals are grouped by the base
+ * signal they belong to in ``table``, so only accesses to the same base have
+ * to be compared. */
+class AccessTracker{
+public:
+    AccessTracker(const SignalTable& table)
+    :table(table), last_barrier(-1), last_position(-1){}
+
+    // Largest position of a recorded operator that conflicts with
+    // ``accesses``, or -1 if there is no such operator.
+    int latest_conflict(const vector<SignalAccess>& accesses) const;
+
+    // Append the positions of all recorded operators that conflict with
+    // ``accesses`` to ``positions``. May contain duplicates.
+    void conflicts(const vector<SignalAccess>& accesses, vector<int>& positions) const;
+
+    void record(const vector<SignalAccess>& accesses, int position);
+    void record_barrier(int position);
+
+    // Largest position recorded so far, or -1.
+    int latest() const { return last_position; }
+
+private:
+    struct Record{
+        SignalExtent extent;
+        int position;
+    };
+
+    int latest_in(const map<const dtype*, vector<Record>>& records, const SignalExtent& extent) const;
+    void all_in(
+        const map<const dtype*, vector<Record>>& records, const SignalExtent& extent,
+        vector<int>& positions) const;
+
+    const SignalTable& table;
+
+    map<const dtype*, vector<Record>> reads;
+    map<const dtype*, vector<Record>> writes;
+
+    int last_barrier;
+    int last_position;
+};
+
+/* Combine independent operators that return the same merge_key into batched
+ * operators, in the spirit of nengo_ocl's plans. ``operators`` must be in
+ * execution order. An operator joins an existing group only if moving it up
+ * to the group's position doesn't reorder it with respect to any operator it
+ * conflicts with, so the result of a step is unchanged. Batched operators are
+ * created with make_batched_operator and appended to ``store``; the returned
+ * list is the new execution order. ``table`` must index the base signals
+ * that the operators access (see AccessTracker). */
+list<Operator*> merge_operators(
+    const list<Operator*>& operators, list<unique_ptr<Operator>>& store,
+    const SignalTable& table);
+
+/* Build the dependency graph of a step. ``operators`` must be in execution
+ * order; operator j is a successor of operator i if i < j and they conflict
+ * (in the sense of AccessTracker), so running the operators in any order
+ * consistent with the graph gives exactly the same results as running them
+ * in sequence. An operator that doesn't declare its accesses depends on all
+ * operators before it, and all operators after it depend on it. Returns the
+ * number of edges. */
+unsigned build_dependency_graph(
+    const vector<Operator*>& operators, const SignalTable& table,
+    vector<vector<unsigned>>& successors, vector<unsigned>& n_predecessors);
+
+/* Reorder ``operators`` (which must be in execution order) to hide MPI
+ * latency, without breaking any dependency from build_dependency_graph.
+ * Whenever there is a choice, operators that an MPISend (transitively)
+ * depends on run first, operators that (transitively) depend on an MPIRecv
+ * run last, and everything else runs in between. Ties keep the original
+ * order. So sends are posted as early as possible, and receives wait as
+ * late as possible, with independent local work in between. */
+list<Operator*> schedule_for_communication(
+    const list<Operator*>& operators, const SignalTable& table);
@@ -1,7 +1,18 @@
 #include "operator.hpp"
+#include "plan.hpp"
+
+dtype* scratch_space(size_t n){
+    static thread_local vector<dtype> buffer;
+
+    if(buffer.size() < n){
+        buffer.resize(n);
+    }
+
+    return buffer.data();
+}
 
 // ********************************************************************************
-TimeUpdate::TimeUpdate(Signal step, Signal time, dtype dt)
+TimeUpdate::TimeUpdate(SignalView step, SignalView time, dtype dt)
 :step(step), time(time), dt(dt){
 
 }
@@ -13,6 +24,22 @@ void TimeUpdate::operator() (){
     run_dbg(*this);
 }
 
+bool TimeUpdate::lower(PlanOp& p) const{
+    p.type = PLAN_TIME_UPDATE;
+    p.ptr[0] = step.data;
+    p.ptr[1] = time.data;
+    p.value[0] = dt;
+
+    return true;
+}
+
+bool TimeUpdate::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(step, ACCESS_UPDATE));
+    accesses.push_back(SignalAccess(time, ACCESS_SET));
+
+    return true;
+}
+
 string TimeUpdate::to_string() const {
 
     stringstream out;
@@ -28,7 +55,7 @@ string TimeUpdate::to_string() const {
 
 
 // ********************************************************************************
-Reset::Reset(Signal dst, dtype value)
+Reset::Reset(SignalView dst, dtype value)
 :dst(dst), value(value){
 
 }
@@ -39,6 +66,25 @@ void Reset::operator() (){
     run_dbg(*this);
 }
 
+bool Reset::lower(PlanOp& p) const{
+    if(!dst.is_contiguous()){
+        return false;
+    }
+
+    p.type = PLAN_RESET;
+    p.ptr[0] = dst.data;
+    p.shape[0] = dst.size();
+    p.value[0] = value;
+
+    return true;
+}
+
+bool Reset::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(dst, ACCESS_SET));
+
+    return true;
+}
+
 string Reset::to_string() const {
 
     stringstream out;
@@ -51,7 +97,7 @@ string Reset::to_string() const {
 }
 
 // ********************************************************************************
-Copy::Copy(Signal dst, Signal src)
+Copy::Copy(SignalView dst, SignalView src)
 :dst(dst), src(src){
 
 }
@@ -62,6 +108,28 @@ void Copy::operator() (){
     run_dbg(*this);
 }
 
+bool Copy::lower(PlanOp& p) const{
+    bool same_shape = dst.shape1 == src.shape1 && dst.shape2 == src.shape2;
+
+    if(!same_shape || !dst.is_contiguous() || !src.is_contiguous()){
+        return false;
+    }
+
+    p.type = PLAN_COPY;
+    p.ptr[0] = dst.data;
+    p.ptr[1] = src.data;
+    p.shape[0] = dst.size();
+
+    return true;
+}
+
+bool Copy::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(src, ACCESS_READ));
+    accesses.push_back(SignalAccess(dst, ACCESS_SET));
+
+    return true;
+}
+
 string Copy::to_string() const  {
 
     stringstream out;
@@ -76,7 +144,7 @@ string Copy::to_string() const  {
 
 // ********************************************************************************
 SlicedCopy::SlicedCopy(
-    Signal src, Signal dst,
+    SignalView src, SignalView dst,
     int start_src, int stop_src, int step_src,
     int start_dst, int stop_dst, int step_dst,
     vector<int> seq_src, vector<int> seq_dst, bool inc)
@@ -128,83 +196,124 @@ seq_src(seq_src), seq_dst(seq_dst){
     }
 
     n_assignments = n_assignments_src;
-}
 
-void SlicedCopy::operator() (){
-    unsigned idx_src, idx_dst;
-    if(seq_src.size() > 0 && seq_dst.size() > 0){
-        if(inc){
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = seq_src[i] % length_src;
-                idx_dst = seq_dst[i] % length_dst;
-
-                dst(idx_dst) += src(idx_src);
-            }
+    // Resolve indices the same way the assignments used to be computed at
+    // every step (including the conversion to unsigned).
+    for(unsigned i = 0; i < n_assignments; i++){
+        unsigned idx_src, idx_dst;
+
+        if(seq_src.size() > 0){
+            idx_src = seq_src[i] % length_src;
         }else{
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = seq_src[i] % length_src;
-                idx_dst = seq_dst[i] % length_dst;
+            idx_src = (start_src + i * step_src) % length_src;
+        }
 
-                dst(idx_dst) = src(idx_src);
-            }
+        if(seq_dst.size() > 0){
+            idx_dst = seq_dst[i] % length_dst;
+        }else{
+            idx_dst = (start_dst + i * step_dst) % length_dst;
         }
 
-    }else if(seq_src.size() > 0){
-        if(inc){
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = seq_src[i] % length_src;
-                idx_dst = (start_dst + i * step_dst) % length_dst;
+        src_offsets.push_back(int(idx_src) * src.stride1);
+        dst_offsets.push_back(int(idx_dst) * dst.stride1);
+    }
 
-                dst(idx_dst) += src(idx_src);
-            }
-        }else{
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = seq_src[i] % length_src;
-                idx_dst = (start_dst + i * step_dst) % length_dst;
+    // Split the assignments into runs with constant, non-zero dst stride
+    // (so that no element is written twice within a run), and gather/scatter
+    // blocks for whatever is left over.
+    const unsigned min_run_length = 4;
 
-                dst(idx_dst) = src(idx_src);
-            }
-        }
+    unsigned i = 0;
+    while(i < n_assignments){
+        unsigned end = i + 1;
+        int src_stride = 0, dst_stride = 0;
 
-    }else if(seq_dst.size() > 0){
-        if(inc){
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = (start_src + i * step_src) % length_src;
-                idx_dst = seq_dst[i] % length_dst;
+        if(i + 1 < n_assignments){
+            src_stride = src_offsets[i + 1] - src_offsets[i];
+            dst_stride = dst_offsets[i + 1] - dst_offsets[i];
 
-                dst(idx_dst) += src(idx_src);
+            while(end < n_assignments &&
+                    src_offsets[end] - src_offsets[end - 1] == src_stride &&
+                    dst_offsets[end] - dst_offsets[end - 1] == dst_stride){
+                end++;
             }
-        }else{
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = (start_src + i * step_src) % length_src;
-                idx_dst = seq_dst[i] % length_dst;
+        }
 
-                dst(idx_dst) = src(idx_src);
+        if(dst_stride != 0 && end - i >= min_run_length){
+            blocks.push_back({true, i, end - i, src_stride, dst_stride});
+            i = end;
+        }else{
+            if(blocks.size() > 0 && !blocks.back().strided){
+                blocks.back().n++;
+            }else{
+                blocks.push_back({false, i, 1, 0, 0});
             }
+            i++;
         }
+    }
 
-    }else{
-        if(inc){
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = (start_src + i * step_src) % length_src;
-                idx_dst = (start_dst + i * step_dst) % length_dst;
+    // Views only know their own addresses, so compare those; views into
+    // different base signals never overlap.
+    aliased = false;
+    if(n_assignments > 0){
+        auto src_range = minmax_element(src_offsets.begin(), src_offsets.end());
+        auto dst_range = minmax_element(dst_offsets.begin(), dst_offsets.end());
 
-                dst(idx_dst) += src(idx_src);
+        uintptr_t src_first = uintptr_t(src.data + *src_range.first);
+        uintptr_t src_last = uintptr_t(src.data + *src_range.second);
+        uintptr_t dst_first = uintptr_t(dst.data + *dst_range.first);
+        uintptr_t dst_last = uintptr_t(dst.data + *dst_range.second);
+
+        aliased = src_first <= dst_last && dst_first <= src_last;
+    }
+}
+
+void SlicedCopy::operator() (){
+    const dtype* src_data = src.data;
+    dtype* dst_data = dst.data;
+
+    for(const Block& b: blocks){
+        if(b.strided){
+            const dtype* s = src_data + src_offsets[b.first];
+            dtype* d = dst_data + dst_offsets[b.first];
+
+            if(inc){
+                for(int k = 0; k < int(b.n); k++){
+                    d[k * b.dst_stride] += s[k * b.src_stride];
+                }
+            }else if(b.src_stride == 1 && b.dst_stride == 1 && !aliased){
+                memcpy(d, s, b.n * sizeof(dtype));
+            }else{
+                for(int k = 0; k < int(b.n); k++){
+                    d[k * b.dst_stride] = s[k * b.src_stride];
+                }
             }
         }else{
-            for(unsigned i = 0; i < n_assignments; i++){
-                idx_src = (start_src + i * step_src) % length_src;
-                idx_dst = (start_dst + i * step_dst) % length_dst;
-
-                dst(idx_dst) = src(idx_src);
+            const int* s = src_offsets.data() + b.first;
+            const int* d = dst_offsets.data() + b.first;
+
+            if(inc){
+                for(unsigned k = 0; k < b.n; k++){
+                    dst_data[d[k]] += src_data[s[k]];
+                }
+            }else{
+                for(unsigned k = 0; k < b.n; k++){
+                    dst_data[d[k]] = src_data[s[k]];
+                }
             }
         }
-
     }
 
     run_dbg(*this);
 }
 
+bool SlicedCopy::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(src, ACCESS_READ));
+    accesses.push_back(SignalAccess(dst, inc ? ACCESS_INC : ACCESS_SET));
+
+    return true;
+}
+
 string SlicedCopy::to_string() const{
 
     stringstream out;
@@ -236,12 +345,16 @@ string SlicedCopy::to_string() const{
     }
     out << endl;
 
+    out << "n_blocks: " << blocks.size() << endl;
+    out << "aliased: " << aliased << endl;
+
     return out.str();
 }
 
 // ********************************************************************************
-DotInc::DotInc(Signal A, Signal X, Signal Y)
-:scalar(A.shape2 != X.shape1), matrix_vector(X.shape2 == 1), A(A), X(X), Y(Y){
+DotInc::DotInc(SignalView A, SignalView X, SignalView Y)
+:scalar(A.shape2 != X.shape1), matrix_vector(X.shape2 == 1), A(A), X(X), Y(Y),
+small_kernel(nullptr){
 
     if(scalar){
         // Scalar multiplication
@@ -274,76 +387,166 @@ DotInc::DotInc(Signal A, Signal X, Signal Y)
         }
 
         if(matrix_vector){
-            m = A.row_major ? A.shape1 : A.shape2;
-            n = A.row_major ? A.shape2 : A.shape1;
+            m = A.row_major() ? A.shape1 : A.shape2;
+            n = A.row_major() ? A.shape2 : A.shape1;
         }else{
             m = Y.shape1;
             n = Y.shape2;
             k = A.shape2;
         }
 
-        // TODO: the requirement that A and X be contiguous can be slightly weakened.
+        // TODO: the requirement that A be contiguous can be slightly weakened.
         // All we really need is that it is stored contiguously along the major dimension.
-        if(!A.is_contiguous){
+        if(!A.is_contiguous()){
             stringstream ss;
             ss << "While creating DotInc, got signal A that is not contiguous. "
                << "A: " << A << endl;
 
             throw runtime_error(ss.str());
         }
-        transpose_A = A.row_major ? CblasNoTrans : CblasTrans;
-        leading_dim_A = A.row_major ? A.stride1 : A.stride2;
+        transpose_A = A.row_major() ? CblasNoTrans : CblasTrans;
+        leading_dim_A = A.row_major() ? A.stride1 : A.stride2;
 
-        if(!X.is_contiguous){
+        // A vector X is passed to gemv (or a small kernel) with its stride,
+        // so it only has to be contiguous if it is a matrix.
+        bool strided_vector = matrix_vector && X.stride1 > 0;
+        if(!X.is_contiguous() && !strided_vector){
             stringstream ss;
             ss << "While creating DotInc, got signal X that is not contiguous. "
                << "X: " << X << endl;
 
             throw runtime_error(ss.str());
         }
-        transpose_X = X.row_major ? CblasNoTrans : CblasTrans;
-        leading_dim_X = X.row_major ? X.stride1 : X.stride2;
+        transpose_X = X.row_major() ? CblasNoTrans : CblasTrans;
+        leading_dim_X = X.row_major() ? X.stride1 : X.stride2;
 
-        if(!Y.row_major){
+        if(!Y.row_major()){
             stringstream ss;
             ss << "While creating DotInc, got signal Y that is not in row-major order. "
                << "Y: " << Y << endl;
             throw runtime_error(ss.str());
         }
         leading_dim_Y = Y.stride1;
+
+        if(matrix_vector && transpose_A == CblasNoTrans && m * n <= SMALL_GEMV_DEFAULT_MAX_SIZE){
+            small_kernel = select_small_gemv(m, n);
+        }
     }
 }
 
 void DotInc::operator() (){
     if(scalar){
         dtype a = A(0);
+        SignalView x = X, y = Y;
 
-        for(unsigned i = 0; i < X.shape1; i++){
-            for(unsigned j = 0; j < X.shape2; j++){
-                Y(i, j) += a * X(i, j);
+        for(unsigned i = 0; i < x.shape1; i++){
+            for(unsigned j = 0; j < x.shape2; j++){
+                y(i, j) += a * x(i, j);
             }
         }
 
     }else if(X.shape2 == 1){
-        cblas_dgemv(
-            CblasRowMajor, transpose_A, m, n, 1.0,
-            A.raw_data, leading_dim_A, X.raw_data, X.stride1,
-            1.0, Y.raw_data, Y.stride1);
+        if(small_kernel){
+            small_kernel(
+                A.data, leading_dim_A, m, n,
+                X.data, X.stride1, Y.data, Y.stride1);
+        }else{
+            cblas_xgemv(
+                CblasRowMajor, transpose_A, m, n, 1.0,
+                A.data, leading_dim_A, X.data, X.stride1,
+                1.0, Y.data, Y.stride1);
+        }
     }else{
-        cblas_dgemm(
+        cblas_xgemm(
             CblasRowMajor, transpose_A, transpose_X, m, n, k,
-            1.0, A.raw_data, leading_dim_A, X.raw_data, leading_dim_X,
-            1.0, Y.raw_data, leading_dim_Y);
+            1.0, A.data, leading_dim_A, X.data, leading_dim_X,
+            1.0, Y.data, leading_dim_Y);
     }
 
     run_dbg(*this);
 }
 
+bool DotInc::lower(PlanOp& p) const{
+    if(scalar){
+        return false;
+    }
+
+    p.ptr[0] = A.data;
+    p.ptr[1] = X.data;
+    p.ptr[2] = Y.data;
+    p.trans[0] = transpose_A;
+    p.stride[0] = leading_dim_A;
+
+    if(X.shape2 == 1){
+        p.type = small_kernel ? PLAN_DOT_INC_SMALL : PLAN_DOT_INC_MV;
+        p.kernel = small_kernel;
+        p.shape[0] = m;
+        p.shape[1] = n;
+        p.stride[1] = X.stride1;
+        p.stride[2] = Y.stride1;
+    }else{
+        p.type = PLAN_DOT_INC_MM;
+        p.trans[1] = transpose_X;
+        p.shape[0] = m;
+        p.shape[1] = n;
+        p.shape[2] = k;
+        p.stride[1] = leading_dim_X;
+        p.stride[2] = leading_dim_Y;
+    }
+
+    return true;
+}
+
+bool DotInc::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(A, ACCESS_READ));
+    accesses.push_back(SignalAccess(X, ACCESS_READ));
+    accesses.push_back(SignalAccess(Y, ACCESS_INC));
+
+    return true;
+}
+
+unique_ptr<Operator> DotInc::sparsify(dtype threshold) const{
+    if(scalar || SparseDotInc::density(A) >= threshold){
+        return unique_ptr<Operator>();
+    }
+
+    return unique_ptr<Operator>(new SparseDotInc(A, X, Y));
+}
+
+unique_ptr<Operator> DotInc::compress(WeightPrecision precision) const{
+    if(scalar || !matrix_vector || precision == WEIGHTS_DOUBLE){
+        return unique_ptr<Operator>();
+    }
+
+    return unique_ptr<Operator>(new CompressedDotInc(A, X, Y, precision));
+}
+
+void DotInc::autotune(){
+    if(scalar || !matrix_vector || transpose_A != CblasNoTrans){
+        return;
+    }
+
+    small_kernel = small_gemv_is_faster(m, n) ? select_small_gemv(m, n) : nullptr;
+}
+
+string DotInc::merge_key() const{
+    // Only row-major A can be processed in blocks of contiguous rows.
+    if(scalar || !matrix_vector || transpose_A != CblasNoTrans){
+        return "";
+    }
+
+    stringstream key;
+    key << classname() << ":" << A.data << ":" << A.shape1 << ":" << A.shape2
+        << ":" << A.stride1 << ":" << A.stride2;
+    return key.str();
+}
+
 string DotInc::to_string() const{
 
     stringstream out;
     out << Operator::to_string();
     out << "scalar: " << scalar << endl;
+    out << "small_kernel: " << (small_kernel != nullptr) << endl;
 
     out << "A:" << endl;
     out << signal_to_string(A) << endl;
@@ -355,8 +558,486 @@ string DotInc::to_string() const{
     return out.str();
 }
 
+unique_ptr<Operator> DotInc::with_spikes(shared_ptr<SpikeList> spikes) const{
+    if(scalar || !matrix_vector){
+        return unique_ptr<Operator>();
+    }
+
+    return unique_ptr<Operator>(new SpikeDotInc(A, X, Y, spikes));
+}
+
+// ********************************************************************************
+SpikeDotInc::SpikeDotInc(SignalView A, SignalView X, SignalView Y, shared_ptr<SpikeList> spikes)
+:DotInc(A, X, Y), spikes(spikes){
+
+    if(scalar || !matrix_vector){
+        stringstream ss;
+        ss << "While creating SpikeDotInc, got shapes that do not describe a "
+           << "matrix-vector product. Shapes are: A - " << shape_string(A)
+           << ", X - " << shape_string(X)
+           << ", Y - " << shape_string(Y) << "." << endl;
+
+        throw runtime_error(ss.str());
+    }
+}
+
+void SpikeDotInc::operator() (){
+    // Accessing a column of A costs about as much as a dense
+    // product over 4 columns, depending on A's layout.
+    if(!spikes->valid || 4 * spikes->n_spikes > A.shape2){
+        DotInc::operator()();
+        return;
+    }
+
+    const dtype* x = X.data;
+    dtype* y = Y.data;
+
+    const unsigned* spiked = spikes->indices.data();
+    const unsigned n_spikes = spikes->n_spikes;
+
+    if(A.stride2 == 1){
+        // Row-major A: gather the spiking columns from each row in turn.
+        for(unsigned i = 0; i < A.shape1; i++){
+            const dtype* a = A.data + int(i) * A.stride1;
+            dtype sum = 0.0;
+
+            for(unsigned s = 0; s < n_spikes; s++){
+                int j = spiked[s];
+                sum += a[j] * x[j * X.stride1];
+            }
+
+            y[int(i) * Y.stride1] += sum;
+        }
+    }else{
+        for(unsigned s = 0; s < n_spikes; s++){
+            int j = spiked[s];
+            const dtype* a = A.data + j * A.stride2;
+            dtype x_j = x[j * X.stride1];
+
+            for(unsigned i = 0; i < A.shape1; i++){
+                y[int(i) * Y.stride1] += a[int(i) * A.stride1] * x_j;
+            }
+        }
+    }
+
+    run_dbg(*this);
+}
+
+string SpikeDotInc::to_string() const{
+
+    stringstream out;
+    out << DotInc::to_string();
+    out << "n_spikes: " << spikes->n_spikes << endl;
+    out << "spikes_valid: " << spikes->valid << endl;
+
+    return out.str();
+}
+
+// ********************************************************************************
+SparseDotInc::SparseDotInc(SignalView A, SignalView X, SignalView Y)
+:X(X), Y(Y), n_rows(A.shape1), n_cols(A.shape2){
+
+    bool bad_shapes =
+        A.shape1 != Y.shape1 || X.shape2 != Y.shape2 || A.shape2 != X.shape1;
+
+    if(bad_shapes){
+        stringstream ss;
+        ss << "While creating SparseDotInc, got mismatching shapes for A, X and Y. "
+           << "Shapes are: A - " << shape_string(A)
+           << ", X - " << shape_string(X)
+           << ", Y - " << shape_string(Y) << "." << endl;
+
+        throw runtime_error(ss.str());
+    }
+
+    row_offsets.push_back(0);
+
+    for(unsigned i = 0; i < n_rows; i++){
+        for(unsigned j = 0; j < n_cols; j++){
+            dtype a = A(i, j);
+
+            if(a != 0.0){
+                values.push_back(a);
+                column_indices.push_back(j);
+            }
+        }
+
+        row_offsets.push_back(values.size());
+    }
+}
+
+void SparseDotInc::operator() (){
+    if(X.shape2 == 1){
+        const dtype* x = X.data;
+        dtype* y = Y.data;
+
+        for(unsigned i = 0; i < n_rows; i++){
+            dtype sum = 0.0;
+
+            for(unsigned k = row_offsets[i]; k < row_offsets[i+1]; k++){
+                sum += values[k] * x[int(column_indices[k]) * X.stride1];
+            }
+
+            y[int(i) * Y.stride1] += sum;
+        }
+    }else{
+        SignalView x = X, y = Y;
+
+        for(unsigned i = 0; i < n_rows; i++){
+            for(unsigned k = row_offsets[i]; k < row_offsets[i+1]; k++){
+                dtype a = values[k];
+                unsigned c = column_indices[k];
+
+                for(unsigned j = 0; j < x.shape2; j++){
+                    y(i, j) += a * x(c, j);
+                }
+            }
+        }
+    }
+
+    run_dbg(*this);
+}
+
+bool SparseDotInc::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(X, ACCESS_READ));
+    accesses.push_back(SignalAccess(Y, ACCESS_INC));
+
+    return true;
+}
+
+dtype SparseDotInc::density(const SignalView& A){
+    if(A.size() == 0){
+        return 1.0;
+    }
+
+    unsigned n_nonzero = 0;
+    for(unsigned i = 0; i < A.shape1; i++){
+        for(unsigned j = 0; j < A.shape2; j++){
+            n_nonzero += A(i, j) != 0.0;
+        }
+    }
+
+    return dtype(n_nonzero) / A.size();
+}
+
+string SparseDotInc::to_string() const{
+
+    stringstream out;
+    out << Operator::to_string();
+    out << "shape: (" << n_rows << ", " << n_cols << ")" << endl;
+    out << "n_nonzero: " << values.size() << endl;
+
+    out << "X:" << endl;
+    out << signal_to_string(X) << endl;
+    out << "Y:" << endl;
+    out << signal_to_string(Y) << endl;
+
+    return out.str();
+}
+
+// ********************************************************************************
+// Conversions between doubles and the reduced-precision formats. Only the
+// expansions are used while simulating, so only they need to be fast.
+
+static float float16_to_float(uint16_t h){
+    dtype magnitude;
+    unsigned exponent = (h >> 10) & 0x1f;
+    unsigned mantissa = h & 0x3ff;
+
+    if(exponent == 0){
+        magnitude = ldexp(dtype(mantissa), -24);
+    }else if(exponent == 0x1f){
+        magnitude = mantissa ? NAN : INFINITY;
+    }else{
+        magnitude = ldexp(dtype(mantissa + 1024), int(exponent) - 25);
+    }
+
+    return float((h & 0x8000) ? -magnitude : magnitude);
+}
+
+// Converting float16s with bit operations takes long enough without hardware
+// support (subnormals in particular) that looking up all 2^16 values in a
+// table is faster.
+static vector<float> make_float16_table(){
+    vector<float> table(1 << 16);
+    for(unsigned h = 0; h < table.size(); h++){
+        table[h] = float16_to_float(uint16_t(h));
+    }
+
+    return table;
+}
+
+static const float* float16_table(){
+    static const vector<float> table = make_float16_table();
+    return table.data();
+}
+
+static inline float bfloat16_to_float(uint16_t h){
+    uint32_t bits = uint32_t(h) << 16;
+
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Rounds to nearest, with ties to even.
+static uint16_t double_to_float16(dtype value){
+    uint16_t sign = signbit(value) ? 0x8000 : 0;
+    dtype magnitude = fabs(value);
+
+    // Spacing of float16s near ``magnitude``; below 2^-14 they're subnormal
+    // and the spacing is fixed at 2^-24.
+    int exponent;
+    frexp(magnitude, &exponent);
+    exponent = max(exponent - 1, -14);
+
+    dtype quantum = ldexp(1.0, exponent - 10);
+    dtype rounded = nearbyint(magnitude / quantum) * quantum;
+
+    if(rounded > 65504.0){
+        return sign | 0x7bff;
+    }
+
+    if(rounded < ldexp(1.0, -14)){
+        return sign | uint16_t(rounded / ldexp(1.0, -24));
+    }
+
+    // Rounding can carry into the next exponent.
+    frexp(rounded, &exponent);
+    exponent -= 1;
+
+    uint16_t mantissa = uint16_t((rounded / ldexp(1.0, exponent) - 1.0) * 1024);
+    return sign | uint16_t((exponent + 15) << 10) | mantissa;
+}
+
+// Rounds to nearest, with ties to even.
+static uint16_t double_to_bfloat16(dtype value){
+    float f = float(value);
+
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return uint16_t(bits >> 16);
+}
+
+struct ExpandFloat16{
+    ExpandFloat16():table(float16_table()){}
+    float operator()(uint16_t h) const { return table[h]; }
+
+    const float* table;
+};
+
+struct ExpandBFloat16{
+    float operator()(uint16_t h) const { return bfloat16_to_float(h); }
+};
+
+struct ExpandInt8{
+    int operator()(int8_t q) const { return q; }
+};
+
+// Number of partial sums kept for each row by compressed_gemv.
+#define COMPRESSED_GEMV_LANES 8
+
+// y += A * x for a row-major m x n A stored as ``Entry``s. Row i is
+// multiplied by scale[i] if scale is not null. Each row keeps several
+// partial sums, so that the expansions and products of consecutive entries
+// are independent and the compiler can interleave them when x is contiguous.
+template<class Entry, class Expand>
+static void compressed_gemv(
+        const Entry* A, const dtype* scale, unsigned m, unsigned n,
+        const dtype* x, int x_stride, dtype* y, int y_stride){
+
+    const unsigned lanes = COMPRESSED_GEMV_LANES;
+
+    Expand expand;
+    unsigned n_vec = x_stride == 1 ? n - n % lanes : 0;
+
+    for(unsigned i = 0; i < m; i++){
+        const Entry* a = A + size_t(i) * n;
+        dtype sum[lanes] = {};
+
+        for(unsigned j = 0; j < n_vec; j += lanes){
+            for(unsigned l = 0; l < lanes; l++){
+                sum[l] += dtype(expand(a[j + l])) * x[j + l];
+            }
+        }
+
+        for(unsigned j = n_vec; j < n; j++){
+            sum[0] += dtype(expand(a[j])) * x[int(j) * x_stride];
+        }
+
+        dtype row_sum = 0.0;
+        for(unsigned l = 0; l < lanes; l++){
+            row_sum += sum[l];
+        }
+
+        y[int(i) * y_stride] += scale ? scale[i] * row_sum : row_sum;
+    }
+}
+
+// ********************************************************************************
+CompressedDotInc::CompressedDotInc(SignalView A, SignalView X, SignalView Y, WeightPrecision precision)
+:weight_error(0.0), product_error(0.0), X(X), Y(Y),
+n_rows(A.shape1), n_cols(A.shape2), precision(precision){
+
+    bool bad_shapes =
+        A.shape1 != Y.shape1 || X.shape1 != A.shape2 || X.shape2 != 1 || Y.shape2 != 1;
+
+    if(bad_shapes){
+        stringstream ss;
+        ss << "While creating CompressedDotInc, got mismatching shapes for A, X and Y. "
+           << "Shapes are: A - " << shape_string(A)
+           << ", X - " << shape_string(X)
+           << ", Y - " << shape_string(Y) << "." << endl;
+
+        throw runtime_error(ss.str());
+    }
+
+    size_t size = size_t(n_rows) * n_cols;
+
+    switch(precision){
+        case WEIGHTS_FLOAT16:
+        case WEIGHTS_BFLOAT16:
+            values_16.resize(size);
+
+            for(unsigned i = 0; i < n_rows; i++){
+                for(unsigned j = 0; j < n_cols; j++){
+                    values_16[size_t(i) * n_cols + j] = precision == WEIGHTS_FLOAT16 ?
+                        double_to_float16(A(i, j)) : double_to_bfloat16(A(i, j));
+                }
+            }
+            break;
+
+        case WEIGHTS_INT8:
+            values_8.resize(size);
+            row_scale.resize(n_rows);
+
+            for(unsigned i = 0; i < n_rows; i++){
+                dtype max_abs = 0.0;
+                for(unsigned j = 0; j < n_cols; j++){
+                    max_abs = max(max_abs, fabs(A(i, j)));
+                }
+
+                row_scale[i] = max_abs / 127.0;
+
+                for(unsigned j = 0; j < n_cols; j++){
+                    dtype q = max_abs > 0.0 ? nearbyint(A(i, j) / row_scale[i]) : 0.0;
+                    values_8[size_t(i) * n_cols + j] = int8_t(max(dtype(-127.0), min(dtype(127.0), q)));
+                }
+            }
+            break;
+
+        default:
+            stringstream ss;
+            ss << "CompressedDotInc can't store A as "
+               << weight_precision_name(precision) << "." << endl;
+            throw runtime_error(ss.str());
+    }
+
+    // Measure the error against the original A, using a pseudo-random x with
+    // entries in [0, 1) (like, e.g., filtered firing rates).
+    minstd_rand rng(n_rows * 7919 + n_cols);
+    uniform_real_distribution<dtype> dist(0.0, 1.0);
+
+    vector<dtype> x(n_cols);
+    for(auto& x_j: x){
+        x_j = dist(rng);
+    }
+
+    dtype max_abs = 0.0, max_error = 0.0;
+    dtype product_norm = 0.0, difference_norm = 0.0;
+
+    for(unsigned i = 0; i < n_rows; i++){
+        dtype exact = 0.0, approx = 0.0;
+
+        for(unsigned j = 0; j < n_cols; j++){
+            dtype a = A(i, j);
+            dtype a_approx = expand(size_t(i) * n_cols + j, i);
+
+            max_abs = max(max_abs, fabs(a));
+            max_error = max(max_error, fabs(a - a_approx));
+
+            exact += a * x[j];
+            approx += a_approx * x[j];
+        }
+
+        product_norm += exact * exact;
+        difference_norm += (exact - approx) * (exact - approx);
+    }
+
+    weight_error = max_abs > 0.0 ? max_error / max_abs : 0.0;
+    product_error = product_norm > 0.0 ? sqrt(difference_norm / product_norm) : 0.0;
+}
+
+dtype CompressedDotInc::expand(size_t k, unsigned row) const{
+    switch(precision){
+        case WEIGHTS_FLOAT16:
+            return float16_table()[values_16[k]];
+        case WEIGHTS_BFLOAT16:
+            return bfloat16_to_float(values_16[k]);
+        case WEIGHTS_INT8:
+            return values_8[k] * row_scale[row];
+        default:
+            return 0.0;
+    }
+}
+
+void CompressedDotInc::operator() (){
+    switch(precision){
+        case WEIGHTS_FLOAT16:
+            compressed_gemv<uint16_t, ExpandFloat16>(
+                values_16.data(), nullptr, n_rows, n_cols,
+                X.data, X.stride1, Y.data, Y.stride1);
+            break;
+        case WEIGHTS_BFLOAT16:
+            compressed_gemv<uint16_t, ExpandBFloat16>(
+                values_16.data(), nullptr, n_rows, n_cols,
+                X.data, X.stride1, Y.data, Y.stride1);
+            break;
+        case WEIGHTS_INT8:
+            compressed_gemv<int8_t, ExpandInt8>(
+                values_8.data(), row_scale.data(), n_rows, n_cols,
+                X.data, X.stride1, Y.data, Y.stride1);
+            break;
+        default:
+            break;
+    }
+
+    run_dbg(*this);
+}
+
+bool CompressedDotInc::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(X, ACCESS_READ));
+    accesses.push_back(SignalAccess(Y, ACCESS_INC));
+
+    return true;
+}
+
+size_t CompressedDotInc::compressed_bytes() const{
+    return values_16.size() * sizeof(uint16_t) + values_8.size() * sizeof(int8_t)
+           + row_scale.size() * sizeof(dtype);
+}
+
+string CompressedDotInc::to_string() const{
+
+    stringstream out;
+    out << Operator::to_string();
+    out << "shape: (" << n_rows << ", " << n_cols << ")" << endl;
+    out << "precision: " << weight_precision_name(precision) << endl;
+    out << "weight_error: " << weight_error << endl;
+    out << "product_error: " << product_error << endl;
+
+    out << "X:" << endl;
+    out << signal_to_string(X) << endl;
+    out << "Y:" << endl;
+    out << signal_to_string(Y) << endl;
+
+    return out.str();
+}
+
 // ********************************************************************************
-ElementwiseInc::ElementwiseInc(Signal A, Signal X, Signal Y)
+ElementwiseInc::ElementwiseInc(SignalView A, SignalView X, SignalView Y)
 :A(A), X(X), Y(Y),
 A_row_stride(A.shape1 > 1 ? 1 : 0), A_col_stride(A.shape2 > 1 ? 1 : 0),
 X_row_stride(X.shape1 > 1 ? 1 : 0), X_col_stride(X.shape2 > 1 ? 1 : 0){
@@ -383,14 +1064,15 @@ X_row_stride(X.shape1 > 1 ? 1 : 0), X_col_stride(X.shape2 > 1 ? 1 : 0){
 }
 
 void ElementwiseInc::operator() (){
+    SignalView a = A, x = X, y = Y;
     unsigned A_i = 0, A_j = 0, X_i = 0, X_j = 0;
 
-    for(unsigned Y_i = 0; Y_i < Y.shape1; Y_i++){
+    for(unsigned Y_i = 0; Y_i < y.shape1; Y_i++){
         A_j = 0;
         X_j = 0;
 
-        for(unsigned Y_j = 0; Y_j < Y.shape2; Y_j++){
-            Y(Y_i, Y_j) += A(A_i, A_j) * X(X_i, X_j);
+        for(unsigned Y_j = 0; Y_j < y.shape2; Y_j++){
+            y(Y_i, Y_j) += a(A_i, A_j) * x(X_i, X_j);
 
             A_j += A_col_stride;
             X_j += X_col_stride;
@@ -403,6 +1085,32 @@ void ElementwiseInc::operator() (){
     run_dbg(*this);
 }
 
+bool ElementwiseInc::lower(PlanOp& p) const{
+    p.type = PLAN_ELEMENTWISE_INC;
+    p.ptr[0] = A.data;
+    p.ptr[1] = X.data;
+    p.ptr[2] = Y.data;
+    p.shape[0] = Y.shape1;
+    p.shape[1] = Y.shape2;
+
+    p.stride[0] = Y.stride1;
+    p.stride[1] = Y.stride2;
+    p.stride[2] = A_row_stride * A.stride1;
+    p.stride[3] = A_col_stride * A.stride2;
+    p.stride[4] = X_row_stride * X.stride1;
+    p.stride[5] = X_col_stride * X.stride2;
+
+    return true;
+}
+
+bool ElementwiseInc::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(A, ACCESS_READ));
+    accesses.push_back(SignalAccess(X, ACCESS_READ));
+    accesses.push_back(SignalAccess(Y, ACCESS_INC));
+
+    return true;
+}
+
 string ElementwiseInc::to_string() const{
 
     stringstream out;
@@ -425,7 +1133,7 @@ string ElementwiseInc::to_string() const{
 
 // ********************************************************************************
 NoDenSynapse::NoDenSynapse(
-    Signal input, Signal output, dtype b)
+    SignalView input, SignalView output, dtype b)
 :input(input), output(output), b(b){
 
     if(input.shape1 != output.shape1 || input.shape2 != output.shape2){
@@ -435,15 +1143,52 @@ NoDenSynapse::NoDenSynapse(
 }
 
 void NoDenSynapse::operator() (){
-    for(unsigned i = 0; i < output.shape1; i++){
-        for(unsigned j = 0; j < output.shape2; j++){
-            output(i, j) = b * input(i, j);
+    SignalView in = input, out = output;
+
+    for(unsigned i = 0; i < out.shape1; i++){
+        for(unsigned j = 0; j < out.shape2; j++){
+            out(i, j) = b * in(i, j);
         }
     }
 
     run_dbg(*this);
 }
 
+bool NoDenSynapse::lower(PlanOp& p) const{
+    p.type = PLAN_NO_DEN_SYNAPSE;
+    p.ptr[0] = input.data;
+    p.ptr[1] = output.data;
+    p.shape[0] = output.shape1;
+    p.shape[1] = output.shape2;
+
+    p.stride[0] = input.stride1;
+    p.stride[1] = input.stride2;
+    p.stride[2] = output.stride1;
+    p.stride[3] = output.stride2;
+
+    p.value[0] = b;
+
+    return true;
+}
+
+bool NoDenSynapse::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(input, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    return true;
+}
+
+string NoDenSynapse::merge_key() const{
+    int stride;
+    if(!flat_stride(input, stride) || !flat_stride(output, stride)){
+        return "";
+    }
+
+    stringstream key;
+    key << setprecision(17) << classname() << ":" << b;
+    return key.str();
+}
+
 string NoDenSynapse::to_string() const{
 
     stringstream out;
@@ -458,7 +1203,7 @@ string NoDenSynapse::to_string() const{
 }
 
 // ********************************************************************************
-SimpleSynapse::SimpleSynapse(Signal input, Signal output, dtype a, dtype b)
+SimpleSynapse::SimpleSynapse(SignalView input, SignalView output, dtype a, dtype b)
 :input(input), output(output), a(a), b(b){
     if(input.shape1 != output.shape1 || input.shape2 != output.shape2){
         throw runtime_error(
@@ -467,16 +1212,54 @@ SimpleSynapse::SimpleSynapse(Signal input, Signal output, dtype a, dtype b)
 }
 
 void SimpleSynapse::operator() (){
-    for(unsigned i = 0; i < output.shape1; i++){
-        for(unsigned j = 0; j < output.shape2; j++){
-            output(i, j) *= -a;
-            output(i, j) += b * input(i, j);
+    SignalView in = input, out = output;
+
+    for(unsigned i = 0; i < out.shape1; i++){
+        for(unsigned j = 0; j < out.shape2; j++){
+            out(i, j) *= -a;
+            out(i, j) += b * in(i, j);
         }
     }
 
     run_dbg(*this);
 }
 
+bool SimpleSynapse::lower(PlanOp& p) const{
+    p.type = PLAN_SIMPLE_SYNAPSE;
+    p.ptr[0] = input.data;
+    p.ptr[1] = output.data;
+    p.shape[0] = output.shape1;
+    p.shape[1] = output.shape2;
+
+    p.stride[0] = input.stride1;
+    p.stride[1] = input.stride2;
+    p.stride[2] = output.stride1;
+    p.stride[3] = output.stride2;
+
+    p.value[0] = a;
+    p.value[1] = b;
+
+    return true;
+}
+
+bool SimpleSynapse::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(input, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_UPDATE));
+
+    return true;
+}
+
+string SimpleSynapse::merge_key() const{
+    int stride;
+    if(!flat_stride(input, stride) || !flat_stride(output, stride)){
+        return "";
+    }
+
+    stringstream key;
+    key << setprecision(17) << classname() << ":" << a << ":" << b;
+    return key.str();
+}
+
 string SimpleSynapse::to_string() const{
 
     stringstream out;
@@ -491,46 +1274,128 @@ string SimpleSynapse::to_string() const{
     return out.str();
 }
 
+// ********************************************************************************
+FilterHistory::FilterHistory(unsigned n, const SignalView& numer_, const SignalView& denom_)
+:n(n), x(numer_.shape1 * n, 0.0), y(denom_.shape1 * n, 0.0),
+x_head(0), y_head(0){
+
+    for(unsigned k = 0; k < numer_.shape1; k++){
+        numer.push_back(numer_(k));
+    }
+
+    for(unsigned k = 0; k < denom_.shape1; k++){
+        denom.push_back(denom_(k));
+    }
+}
+
+dtype* FilterHistory::push_input(dtype* scratch){
+    unsigned order = numer.size();
+    if(order == 0){
+        return scratch;
+    }
+
+    x_head = (x_head + order - 1) % order;
+    return x.data() + x_head * n;
+}
+
+void FilterHistory::step(dtype* out){
+    // Same arithmetic, in the same order for each element, as
+    // out = sum_k numer[k] * x[k] - sum_k denom[k] * y[k].
+    fill(out, out + n, 0.0);
+
+    unsigned order = numer.size();
+    for(unsigned k = 0; k < order; k++){
+        const dtype* row = x.data() + ((x_head + k) % order) * n;
+        const dtype c = numer[k];
+
+        for(unsigned e = 0; e < n; e++){
+            out[e] += c * row[e];
+        }
+    }
+
+    order = denom.size();
+    for(unsigned k = 0; k < order; k++){
+        const dtype* row = y.data() + ((y_head + k) % order) * n;
+        const dtype c = denom[k];
+
+        for(unsigned e = 0; e < n; e++){
+            out[e] -= c * row[e];
+        }
+    }
+
+    if(order > 0){
+        y_head = (y_head + order - 1) % order;
+        copy(out, out + n, y.data() + y_head * n);
+    }
+}
+
+void FilterHistory::reset(){
+    fill(x.begin(), x.end(), 0.0);
+    fill(y.begin(), y.end(), 0.0);
+    x_head = 0;
+    y_head = 0;
+}
+
 // ********************************************************************************
 Synapse::Synapse(
-    Signal input, Signal output, Signal numer, Signal denom)
-:input(input), output(output), numer(numer), denom(denom){
+    SignalView input, SignalView output, SignalView numer, SignalView denom)
+:input(input), output(output), numer(numer), denom(denom),
+history(output.size(), numer, denom){
     if(input.shape1 != output.shape1 || input.shape2 != output.shape2){
         throw runtime_error(
             "While creating Synapse, input and output had incompatible dimensions.");
     }
+}
 
-    for(unsigned i = 0; i < output.shape1; i++){
-        for(unsigned j = 0; j < output.shape2; j++){
-            x.push_back(boost::circular_buffer<dtype>(numer.shape1));
-            y.push_back(boost::circular_buffer<dtype>(denom.shape1));
+void Synapse::operator() (){
+    SignalView in = input, out = output;
+    dtype* y = scratch_space(history.size());
+    dtype* x = history.push_input(y);
+
+    unsigned idx = 0;
+    for(unsigned i = 0; i < in.shape1; i++){
+        for(unsigned j = 0; j < in.shape2; j++){
+            x[idx++] = in(i, j);
         }
     }
+
+    history.step(y);
+
+    idx = 0;
+    for(unsigned i = 0; i < out.shape1; i++){
+        for(unsigned j = 0; j < out.shape2; j++){
+            out(i, j) = y[idx++];
+        }
+    }
+
+    run_dbg(*this);
 }
 
-void Synapse::operator() (){
-    unsigned idx = 0;
-    for(unsigned i = 0; i < output.shape1; i++){
-        for(unsigned j = 0; j < output.shape2; j++){
-            x[idx].push_front(input(i, j));
+bool Synapse::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(input, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
 
-            output(i, j) = 0.0;
+    return true;
+}
 
-            for(unsigned k = 0; k < x[idx].size(); k++){
-                output(i, j) += numer(k) * x[idx][k];
-            }
+string Synapse::merge_key() const{
+    int stride;
+    if(!flat_stride(input, stride) || !flat_stride(output, stride)){
+        return "";
+    }
 
-            for(unsigned k = 0; k < y[idx].size(); k++){
-                output(i, j) -= denom(k) * y[idx][k];
-            }
+    stringstream key;
+    key << setprecision(17) << classname() << ":" << numer.shape1 << ":" << denom.shape1;
 
-            y[idx].push_front(output(i, j));
+    for(unsigned k = 0; k < numer.shape1; k++){
+        key << ":" << numer(k);
+    }
 
-            idx++;
-        }
+    for(unsigned k = 0; k < denom.shape1; k++){
+        key << ":" << denom(k);
     }
 
-    run_dbg(*this);
+    return key.str();
 }
 
 string Synapse::to_string() const{
@@ -546,79 +1411,74 @@ string Synapse::to_string() const{
     out << "denom:" << endl;
     out << denom << endl;
 
-    /*
-    out << "x & y:" << endl;
-    for(unsigned i = 0; i < input.size(); i++){
-        out << "i: " << i << endl;
-
-        out << "x.size " << x[i].size() << endl;
-        for(unsigned j = 0; j < x[i].size(); j++){
-            out << "x[ "<< j << "] = "<< x[i][j] << ", ";
-        }
-        out << endl;
-
-        out << "y.size " << y[i].size() << endl;
-        for(unsigned j = 0; j < y[i].size(); j++){
-            out << "y[ "<< j << "] = "<< y[i][j] << ", ";
-        }
-        out << endl;
-    }
-    */
-
     return out.str();
 }
 
 void Synapse::reset(unsigned seed){
-    unsigned idx = 0;
-    for(unsigned i = 0; i < output.shape1; i++){
-        for(unsigned j = 0; j < output.shape2; j++){
-            for(unsigned k = 0; k < x[idx].size(); k++){
-                x[idx][k] = 0.0;
-            }
-
-            for(unsigned k = 0; k < y[idx].size(); k++){
-                y[idx][k] = 0.0;
-            }
-            idx++;
-        }
-    }
+    history.reset();
 }
 
 // ********************************************************************************
 TriangleSynapse::TriangleSynapse(
-    Signal input, Signal output, dtype n0, dtype ndiff, unsigned n_taps)
-:input(input), output(output), n0(n0), ndiff(ndiff), n_taps(n_taps){
+    SignalView input, SignalView output, dtype n0, dtype ndiff, unsigned n_taps)
+:input(input), output(output), n0(n0), ndiff(ndiff), n_taps(n_taps),
+taps(n_taps * output.size(), 0.0), head(0), tap_sums(output.size(), 0.0){
 
     if(input.shape1 != output.shape1 || input.shape2 != output.shape2){
         throw runtime_error(
             "While creating TriangleSynapse, input and output had incompatible dimensions.");
     }
-
-    for(unsigned i = 0; i < output.shape1; i++){
-        for(unsigned j = 0; j < output.shape2; j++){
-            x.push_back(boost::circular_buffer<dtype>(n_taps));
-        }
-    }
 }
 
 void TriangleSynapse::operator() (){
+    // output += n0 * input - (sum of the last n_taps values of ndiff * input)
+    // Then the newest value replaces the oldest one in the ring.
+    dtype* oldest = n_taps > 0 ? taps.data() + head * output.size() : nullptr;
+
     unsigned idx = 0;
     for(unsigned i = 0; i < output.shape1; i++){
         for(unsigned j = 0; j < output.shape2; j++){
-            output(i, j) += n0 * input(i, j);
+            dtype in = input.data[int(i) * input.stride1 + int(j) * input.stride2];
+            dtype& out = output.data[int(i) * output.stride1 + int(j) * output.stride2];
 
-            for(unsigned k = 0; k < x[idx].size(); k++){
-                output(i, j) -= x[idx][k];
+            out += n0 * in;
+            out -= tap_sums[idx];
+
+            if(n_taps > 0){
+                dtype x = ndiff * in;
+                tap_sums[idx] += x - oldest[idx];
+                oldest[idx] = x;
             }
 
-            x[idx].push_front(ndiff * input(i, j));
             idx++;
         }
     }
 
+    if(n_taps > 0){
+        head = (head + 1) % n_taps;
+
+        if(head == 0){
+            fill(tap_sums.begin(), tap_sums.end(), 0.0);
+
+            for(unsigned k = 0; k < n_taps; k++){
+                const dtype* row = taps.data() + k * output.size();
+                for(unsigned e = 0; e < output.size(); e++){
+                    tap_sums[e] += row[e];
+                }
+            }
+        }
+    }
+
     run_dbg(*this);
 }
 
+bool TriangleSynapse::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(input, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_UPDATE));
+
+    return true;
+}
+
 string TriangleSynapse::to_string() const{
 
     stringstream out;
@@ -631,38 +1491,18 @@ string TriangleSynapse::to_string() const{
     out << "ndiff:" << ndiff << endl;
     out << "n_taps: " << n_taps << endl;
 
-    /*
-    out << "x :" << endl;
-    for(unsigned i = 0; i < input.size(); i++){
-        out << "i: " << i << endl;
-
-        out << "x.size " << x[i].size() << endl;
-        for(unsigned j = 0; j < x[i].size(); j++){
-            out << "x[ "<< j << "] = "<< x[i][j] << ", ";
-        }
-        out << endl;
-    }
-    */
-
     return out.str();
 }
 
 void TriangleSynapse::reset(unsigned seed){
-    unsigned idx = 0;
-    for(unsigned i = 0; i < output.shape1; i++){
-        for(unsigned j = 0; j < output.shape2; j++){
-            for(unsigned k = 0; k < x[idx].size(); k++){
-                x[idx][k] = 0.0;
-            }
-
-            idx++;
-        }
-    }
+    fill(taps.begin(), taps.end(), 0.0);
+    fill(tap_sums.begin(), tap_sums.end(), 0.0);
+    head = 0;
 }
 
 // ********************************************************************************
 WhiteNoise::WhiteNoise(
-    Signal output, dtype mean, dtype std, bool do_scale, bool inc, dtype dt)
+    SignalView output, dtype mean, dtype std, bool do_scale, bool inc, dtype dt)
 :output(output), mean(mean), std(std), dist(mean, std),
 alpha(do_scale ? 1.0 / dt : 1.0), do_scale(do_scale), inc(inc), dt(dt){
 
@@ -682,6 +1522,12 @@ void WhiteNoise::operator() (){
     run_dbg(*this);
 }
 
+bool WhiteNoise::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(output, inc ? ACCESS_INC : ACCESS_SET));
+
+    return true;
+}
+
 string WhiteNoise::to_string() const{
 
     stringstream out;
@@ -702,7 +1548,7 @@ void WhiteNoise::reset(unsigned seed){
 }
 
 // ********************************************************************************
-WhiteSignal::WhiteSignal(Signal coefs, Signal output, Signal time, dtype dt)
+WhiteSignal::WhiteSignal(SignalView coefs, SignalView output, SignalView time, dtype dt)
 :coefs(coefs), output(output), time(time), dt(dt){
 
 }
@@ -716,6 +1562,13 @@ void WhiteSignal::operator() (){
     run_dbg(*this);
 }
 
+bool WhiteSignal::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(time, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    return true;
+}
+
 string WhiteSignal::to_string() const{
 
     stringstream out;
@@ -732,7 +1585,7 @@ string WhiteSignal::to_string() const{
 }
 
 // ********************************************************************************
-PresentInput::PresentInput(Signal input, Signal output, Signal time, dtype presentation_time, dtype dt)
+PresentInput::PresentInput(SignalView input, SignalView output, SignalView time, dtype presentation_time, dtype dt)
 :input(input), output(output), time(time), presentation_time(presentation_time), dt(dt){
 
 }
@@ -746,6 +1599,13 @@ void PresentInput::operator() (){
     run_dbg(*this);
 }
 
+bool PresentInput::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(time, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    return true;
+}
+
 string PresentInput::to_string() const{
 
     stringstream out;
@@ -763,68 +1623,74 @@ string PresentInput::to_string() const{
 }
 
 
+// ********************************************************************************
+void SpikeList::record(const dtype* output, int stride, unsigned n){
+    if(indices.size() < n){
+        indices.resize(n);
+    }
+
+    // Branch-free, since whether a neuron spiked is unpredictable.
+    unsigned* out = indices.data();
+    unsigned count = 0;
+
+    for(unsigned i = 0; i < n; i++){
+        out[count] = i;
+        count += output[int(i) * stride] != 0.0;
+    }
+
+    n_spikes = count;
+    valid = true;
+}
+
 // ********************************************************************************
 LIF::LIF(
     unsigned n_neurons, dtype tau_rc, dtype tau_ref, dtype min_voltage,
-    dtype dt, Signal J, Signal output, Signal voltage,
-    Signal ref_time)
+    dtype dt, SignalView J, SignalView output, SignalView voltage,
+    SignalView ref_time)
 :n_neurons(n_neurons), dt(dt), dt_inv(1.0 / dt), tau_rc(tau_rc), tau_ref(tau_ref),
 min_voltage(min_voltage), J(J), output(output), voltage(voltage), ref_time(ref_time),
-one(n_neurons, (dtype) 1.0), mult(n_neurons), dV(n_neurons){
+params(tau_rc, tau_ref, min_voltage, dt){
 
 }
 
 void LIF::operator() (){
-    // dV = -expm1(-dt / tau_rc) * (J - voltage)
-    cblas_dcopy(n_neurons, J.raw_data, J.stride1, dV.raw_data, dV.stride1);
-    cblas_daxpy(n_neurons, -1.0, voltage.raw_data, voltage.stride1, dV.raw_data, dV.stride1);
-    dtype scale = -expm1(-dt / tau_rc);
-    cblas_dscal(n_neurons, scale, dV.raw_data, dV.stride1);
-
-    // voltage += dV
-    cblas_daxpy(n_neurons, 1.0, dV.raw_data, dV.stride1, voltage.raw_data, voltage.stride1);
-
-    // voltage = max(voltage, 0)
-    dtype v;
-    for(unsigned i = 0; i < n_neurons; ++i){
-        v = voltage(i);
-        voltage(i) = v < min_voltage ? min_voltage : v;
-    }
+    lif_kernel(
+        params, n_neurons, J.data, J.stride1, output.data, output.stride1,
+        voltage.data, voltage.stride1, ref_time.data, ref_time.stride1);
 
-    // ref_time -= dt_vec
-    cblas_daxpy(n_neurons, -dt, one.raw_data, one.stride1,
-                ref_time.raw_data, ref_time.stride1);
+    record_spikes();
 
-    // mult = -dt_inv * ref_time + 1
-    cblas_dcopy(n_neurons, ref_time.raw_data, ref_time.stride1, mult.raw_data, mult.stride1);
-    cblas_dscal(n_neurons, -dt_inv, mult.raw_data, mult.stride1);
-    cblas_daxpy(n_neurons, 1.0, one.raw_data, one.stride1, mult.raw_data, mult.stride1);
+    run_dbg(*this);
+}
 
-    // mult = mult.clip(0, 1)
-    dtype m;
-    for(unsigned i = 0; i < n_neurons; ++i){
-        m = mult(i);
-        mult(i) = m > 1.0 ? 1.0 : (m < 0.0 ? 0.0 : m);
+void LIF::reset(unsigned seed){
+    if(spikes){
+        spikes->valid = false;
     }
+}
 
-    dtype overshoot;
-    for(unsigned i = 0; i < n_neurons; ++i){
-        voltage(i) *= mult(i);
-        v = voltage(i);
-        if(v > 1.0){
-            output(i) = dt_inv;
-            overshoot = (v - 1.0) / dV(i);
-            ref_time(i) = tau_ref + dt * (1.0 - overshoot);
-            voltage(i) = 0.0;
-        }
-        else
-        {
-            output(i) = 0.0;
-        }
+shared_ptr<SpikeList> LIF::get_spike_list(){
+    if(!spikes){
+        spikes = make_shared<SpikeList>();
     }
 
-    run_dbg(*this);
+    return spikes;
+}
 
+bool LIF::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(J, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+    accesses.push_back(SignalAccess(voltage, ACCESS_UPDATE));
+    accesses.push_back(SignalAccess(ref_time, ACCESS_UPDATE));
+
+    return true;
+}
+
+string LIF::merge_key() const{
+    stringstream key;
+    key << setprecision(17) << classname() << ":"
+        << tau_rc << ":" << tau_ref << ":" << min_voltage << ":" << dt;
+    return key.str();
 }
 
 string LIF::to_string() const{
@@ -850,7 +1716,7 @@ string LIF::to_string() const{
 
 // ********************************************************************************
 LIFRate::LIFRate(
-    unsigned n_neurons, dtype tau_rc, dtype tau_ref, Signal J, Signal output)
+    unsigned n_neurons, dtype tau_rc, dtype tau_ref, SignalView J, SignalView output)
 :n_neurons(n_neurons), tau_rc(tau_rc), tau_ref(tau_ref), J(J), output(output){
 
 }
@@ -868,6 +1734,13 @@ void LIFRate::operator() (){
     run_dbg(*this);
 }
 
+bool LIFRate::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(J, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    return true;
+}
+
 string LIFRate::to_string() const{
 
     stringstream out;
@@ -886,35 +1759,35 @@ string LIFRate::to_string() const{
 // ********************************************************************************
 AdaptiveLIF::AdaptiveLIF(
     unsigned n_neurons, dtype tau_n, dtype inc_n, dtype tau_rc, dtype tau_ref,
-    dtype min_voltage, dtype dt, Signal J, Signal output, Signal voltage,
-    Signal ref_time, Signal adaptation)
+    dtype min_voltage, dtype dt, SignalView J, SignalView output, SignalView voltage,
+    SignalView ref_time, SignalView adaptation)
 :LIF(n_neurons, tau_rc, tau_ref, min_voltage, dt, J, output, voltage, ref_time),
-tau_n(tau_n), inc_n(inc_n), adaptation(adaptation), temp_J(n_neurons), dAdapt(n_neurons){
+tau_n(tau_n), inc_n(inc_n), adaptation(adaptation), adapt_params(tau_n, inc_n, dt){
 
 }
 
 void AdaptiveLIF::operator() (){
-    // temp_J = J
-    cblas_dcopy(n_neurons, J.raw_data, J.stride1, temp_J.raw_data, temp_J.stride1);
+    adaptive_lif_kernel(
+        params, adapt_params, n_neurons, J.data, J.stride1,
+        output.data, output.stride1, voltage.data, voltage.stride1,
+        ref_time.data, ref_time.stride1, adaptation.data, adaptation.stride1);
 
-    // J -= adaptation
-    cblas_daxpy(n_neurons, -1.0, adaptation.raw_data, adaptation.stride1,
-                J.raw_data, J.stride1);
+    record_spikes();
 
-    LIF::operator()();
+    run_dbg(*this);
+}
 
-    // J = temp_J
-    cblas_dcopy(n_neurons, temp_J.raw_data, temp_J.stride1, J.raw_data, J.stride1);
+bool AdaptiveLIF::get_accesses(vector<SignalAccess>& accesses) const{
+    LIF::get_accesses(accesses);
+    accesses.push_back(SignalAccess(adaptation, ACCESS_UPDATE));
 
-    // adaptation += (dt / tau_n) * (inc_n * output - adaptation);
-    cblas_dcopy(n_neurons, output.raw_data, output.stride1, dAdapt.raw_data, dAdapt.stride1);
-    cblas_dscal(n_neurons, inc_n, dAdapt.raw_data, dAdapt.stride1);
-    cblas_daxpy(n_neurons, -1.0, adaptation.raw_data, adaptation.stride1,
-                dAdapt.raw_data, dAdapt.stride1);
-    cblas_daxpy(n_neurons, dt/tau_n, dAdapt.raw_data, dAdapt.stride1,
-                adaptation.raw_data, adaptation.stride1);
+    return true;
+}
 
-    run_dbg(*this);
+string AdaptiveLIF::merge_key() const{
+    stringstream key;
+    key << setprecision(17) << LIF::merge_key() << ":" << tau_n << ":" << inc_n;
+    return key.str();
 }
 
 string AdaptiveLIF::to_string() const{
@@ -932,37 +1805,46 @@ string AdaptiveLIF::to_string() const{
 // ********************************************************************************
 AdaptiveLIFRate::AdaptiveLIFRate(
     unsigned n_neurons, dtype tau_n, dtype inc_n, dtype tau_rc, dtype tau_ref, dtype dt,
-    Signal J, Signal output, Signal adaptation)
+    SignalView J, SignalView output, SignalView adaptation)
 :LIFRate(n_neurons, tau_rc, tau_ref, J, output),
-tau_n(tau_n), inc_n(inc_n), dt(dt), adaptation(adaptation),
-temp_J(n_neurons), dAdapt(n_neurons){
+tau_n(tau_n), inc_n(inc_n), dt(dt), adaptation(adaptation){
 
 }
 
 void AdaptiveLIFRate::operator() (){
+    dtype* temp_J = scratch_space(scratch_size());
+    dtype* dAdapt = temp_J + n_neurons;
+
     // temp_J = J
-    cblas_dcopy(n_neurons, J.raw_data, J.stride1, temp_J.raw_data, temp_J.stride1);
+    cblas_xcopy(n_neurons, J.data, J.stride1, temp_J, 1);
 
     // J -= adaptation
-    cblas_daxpy(n_neurons, -1.0, adaptation.raw_data, adaptation.stride1,
-                J.raw_data, J.stride1);
+    cblas_xaxpy(n_neurons, -1.0, adaptation.data, adaptation.stride1,
+                J.data, J.stride1);
 
     LIFRate::operator()();
 
     // J = temp_J
-    cblas_dcopy(n_neurons, temp_J.raw_data, temp_J.stride1, J.raw_data, J.stride1);
+    cblas_xcopy(n_neurons, temp_J, 1, J.data, J.stride1);
 
     // adaptation += (dt / tau_n) * (inc_n * output - adaptation);
-    cblas_dcopy(n_neurons, output.raw_data, output.stride1, dAdapt.raw_data, dAdapt.stride1);
-    cblas_dscal(n_neurons, inc_n, dAdapt.raw_data, dAdapt.stride1);
-    cblas_daxpy(n_neurons, -1.0, adaptation.raw_data, adaptation.stride1,
-                dAdapt.raw_data, dAdapt.stride1);
-    cblas_daxpy(n_neurons, dt/tau_n, dAdapt.raw_data, dAdapt.stride1,
-                adaptation.raw_data, adaptation.stride1);
+    cblas_xcopy(n_neurons, output.data, output.stride1, dAdapt, 1);
+    cblas_xscal(n_neurons, inc_n, dAdapt, 1);
+    cblas_xaxpy(n_neurons, -1.0, adaptation.data, adaptation.stride1, dAdapt, 1);
+    cblas_xaxpy(n_neurons, dt/tau_n, dAdapt, 1, adaptation.data, adaptation.stride1);
 
     run_dbg(*this);
 }
 
+bool AdaptiveLIFRate::get_accesses(vector<SignalAccess>& accesses) const{
+    // J is modified in place while the step is being computed, then restored.
+    accesses.push_back(SignalAccess(J, ACCESS_UPDATE));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+    accesses.push_back(SignalAccess(adaptation, ACCESS_UPDATE));
+
+    return true;
+}
+
 string AdaptiveLIFRate::to_string() const{
 
     stringstream out;
@@ -977,7 +1859,7 @@ string AdaptiveLIFRate::to_string() const{
 }
 
 // ********************************************************************************
-RectifiedLinear::RectifiedLinear(unsigned n_neurons, Signal J, Signal output)
+RectifiedLinear::RectifiedLinear(unsigned n_neurons, SignalView J, SignalView output)
 :n_neurons(n_neurons), J(J), output(output){
 
 }
@@ -992,6 +1874,13 @@ void RectifiedLinear::operator() (){
     run_dbg(*this);
 }
 
+bool RectifiedLinear::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(J, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    return true;
+}
+
 string RectifiedLinear::to_string() const{
 
     stringstream out;
@@ -1006,7 +1895,7 @@ string RectifiedLinear::to_string() const{
 }
 
 // ********************************************************************************
-Sigmoid::Sigmoid(unsigned n_neurons, dtype tau_ref, Signal J, Signal output)
+Sigmoid::Sigmoid(unsigned n_neurons, dtype tau_ref, SignalView J, SignalView output)
 :n_neurons(n_neurons), tau_ref(tau_ref), tau_ref_inv(1.0 / tau_ref), J(J), output(output){
 
 }
@@ -1019,6 +1908,13 @@ void Sigmoid::operator() (){
     run_dbg(*this);
 }
 
+bool Sigmoid::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(J, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    return true;
+}
+
 string Sigmoid::to_string() const{
 
     stringstream out;
@@ -1035,27 +1931,38 @@ string Sigmoid::to_string() const{
 
 // ********************************************************************************
 BCM::BCM(
-    Signal pre_filtered, Signal post_filtered, Signal theta,
-    Signal delta, dtype learning_rate, dtype dt)
+    SignalView pre_filtered, SignalView post_filtered, SignalView theta,
+    SignalView delta, dtype learning_rate, dtype dt)
 :alpha(learning_rate * dt), pre_filtered(pre_filtered), post_filtered(post_filtered),
-theta(theta), delta(delta), squared_pf(post_filtered.size){
+theta(theta), delta(delta){
 
 }
 
 void BCM::operator() (){
+    dtype* squared_pf = scratch_space(scratch_size());
+
     for(unsigned i = 0; i < post_filtered.shape1; i++){
-        squared_pf(i) = post_filtered(i) * (post_filtered(i) - theta(i));
+        squared_pf[i] = post_filtered(i) * (post_filtered(i) - theta(i));
     }
 
     delta.fill_with(0.0);
 
-    cblas_dger(
-        CblasRowMajor, delta.shape1, delta.shape2, alpha, squared_pf.raw_data, squared_pf.stride1,
-        pre_filtered.raw_data, pre_filtered.stride1, delta.raw_data, delta.stride1);
+    cblas_xger(
+        CblasRowMajor, delta.shape1, delta.shape2, alpha, squared_pf, 1,
+        pre_filtered.data, pre_filtered.stride1, delta.data, delta.stride1);
 
     run_dbg(*this);
 }
 
+bool BCM::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(pre_filtered, ACCESS_READ));
+    accesses.push_back(SignalAccess(post_filtered, ACCESS_READ));
+    accesses.push_back(SignalAccess(theta, ACCESS_READ));
+    accesses.push_back(SignalAccess(delta, ACCESS_SET));
+
+    return true;
+}
+
 string BCM::to_string() const{
     stringstream out;
     out << Operator::to_string();
@@ -1075,8 +1982,8 @@ string BCM::to_string() const{
 
 // ********************************************************************************
 Oja::Oja(
-    Signal pre_filtered, Signal post_filtered, Signal weights,
-    Signal delta, dtype learning_rate, dtype dt, dtype beta)
+    SignalView pre_filtered, SignalView post_filtered, SignalView weights,
+    SignalView delta, dtype learning_rate, dtype dt, dtype beta)
 :alpha(learning_rate * dt), beta(beta), pre_filtered(pre_filtered),
 post_filtered(post_filtered), weights(weights), delta(delta){
 
@@ -1092,13 +1999,22 @@ void Oja::operator() (){
         }
     }
 
-    cblas_dger(
-        CblasRowMajor, delta.shape1, delta.shape2, alpha, post_filtered.raw_data, post_filtered.stride1,
-        pre_filtered.raw_data, pre_filtered.stride1, delta.raw_data, delta.stride1);
+    cblas_xger(
+        CblasRowMajor, delta.shape1, delta.shape2, alpha, post_filtered.data, post_filtered.stride1,
+        pre_filtered.data, pre_filtered.stride1, delta.data, delta.stride1);
 
     run_dbg(*this);
 }
 
+bool Oja::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(pre_filtered, ACCESS_READ));
+    accesses.push_back(SignalAccess(post_filtered, ACCESS_READ));
+    accesses.push_back(SignalAccess(weights, ACCESS_READ));
+    accesses.push_back(SignalAccess(delta, ACCESS_SET));
+
+    return true;
+}
+
 string Oja::to_string() const{
     stringstream out;
     out << Operator::to_string();
@@ -1119,8 +2035,8 @@ string Oja::to_string() const{
 
 // ********************************************************************************
 Voja::Voja(
-    Signal pre_decoded, Signal post_filtered, Signal scaled_encoders,
-    Signal delta, Signal learning_signal, Signal scale,
+    SignalView pre_decoded, SignalView post_filtered, SignalView scaled_encoders,
+    SignalView delta, SignalView learning_signal, SignalView scale,
     dtype learning_rate, dtype dt)
 :alpha(learning_rate * dt), pre_decoded(pre_decoded), post_filtered(post_filtered),
 scaled_encoders(scaled_encoders), delta(delta), learning_signal(learning_signal), scale(scale){
@@ -1145,6 +2061,16 @@ void Voja::operator() (){
     run_dbg(*this);
 }
 
+bool Voja::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(pre_decoded, ACCESS_READ));
+    accesses.push_back(SignalAccess(post_filtered, ACCESS_READ));
+    accesses.push_back(SignalAccess(scaled_encoders, ACCESS_READ));
+    accesses.push_back(SignalAccess(learning_signal, ACCESS_READ));
+    accesses.push_back(SignalAccess(delta, ACCESS_SET));
+
+    return true;
+}
+
 string Voja::to_string() const{
     stringstream out;
     out << Operator::to_string();
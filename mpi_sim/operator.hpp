@@ -4,9 +4,13 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <iomanip>
 #include <memory>
 #include <random>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 #include <boost/circular_buffer.hpp>
 #include <boost/algorithm/string.hpp>
@@ -24,6 +28,9 @@ extern "C"
 #endif
 
 #include "signal.hpp"
+#include "neuron_kernels.hpp"
+#include "small_gemv.hpp"
+#include "config.hpp"
 #include "typedef.hpp"
 #include "debug.hpp"
 
@@ -36,11 +43,37 @@ using namespace std;
 // by the order they are given to us from python.
 //
 // Note that the () operator is a virtual function, which comes with some overhead.
-// Future optimizations should look at another scheme, either function pointers
-// or, ideally, finding some way to make these functions non-pointers and non-virtual.
+// To avoid it, operators can override ``lower``, which describes the operator
+// as a PlanOp record that an ExecutionPlan (plan.hpp) runs with a switch instead
+// of a virtual call. Operators that can't be lowered are called through () as before.
 //
 // Note that in general reset must be called before the () operator can be called.
 
+struct PlanOp;
+struct SpikeList;
+
+// How an operator touches a signal during a step, following the
+// reads/sets/incs/updates distinction that nengo makes for its operators.
+enum AccessType{
+    ACCESS_READ,
+    ACCESS_SET,
+    ACCESS_INC,
+    ACCESS_UPDATE
+};
+
+struct SignalAccess{
+    SignalAccess(SignalView signal, AccessType type):signal(signal), type(type){}
+
+    SignalView signal;
+    AccessType type;
+};
+
+/* Return a buffer of at least ``n`` dtypes for temporaries that don't outlive
+ * a single call of an operator's () operator. Each thread has one buffer,
+ * shared by all the operators that it runs, which grows to the largest size
+ * asked for; the contents are undefined. */
+dtype* scratch_space(size_t n);
+
 class Operator{
 
 public:
@@ -56,6 +89,26 @@ public:
     virtual string classname() const { return "Operator"; }
 
     virtual void operator() () = 0;
+
+    // Fill in ``p`` so that running it has the same effect as calling
+    // the () operator. Return false if the operator can't be lowered.
+    virtual bool lower(PlanOp& p) const { return false; }
+
+    // Append every signal that the () operator touches to ``accesses``.
+    // Return false if the operator doesn't declare its accesses; build-time
+    // passes then have to assume that it may touch anything.
+    virtual bool get_accesses(vector<SignalAccess>& accesses) const { return false; }
+
+    // Operators that return the same non-empty key are of the same type, have
+    // compatible parameters, and can be combined into a single batched operator
+    // by make_batched_operator (batched_operator.hpp).
+    virtual string merge_key() const { return ""; }
+
+    // Return true if the () operator may only be called from the thread that
+    // runs the simulation (e.g. because it makes MPI or python calls), rather
+    // than from one of ParallelExecutor's worker threads.
+    virtual bool requires_main_thread() const { return false; }
+
     virtual string to_string() const{
         stringstream ss;
         ss << classname() << endl;
@@ -63,6 +116,10 @@ public:
         return ss.str();
     }
 
+    // Number of dtypes of scratch space (see scratch_space) used by the ()
+    // operator.
+    virtual size_t scratch_size() const { return 0; }
+
     // Here we only need to reset aspects of operator's state that are *not* stored as signals
     // because resetting signals is handled by the chunk. Consequently, most operators won't
     // need to override this.
@@ -85,15 +142,17 @@ protected:
 class TimeUpdate: public Operator{
 
 public:
-    TimeUpdate(Signal step, Signal time, dtype t);
+    TimeUpdate(SignalView step, SignalView time, dtype t);
     virtual string classname() const { return "TimeUpdate"; }
 
     void operator()();
+    bool lower(PlanOp& p) const;
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
-    Signal step;
-    Signal time;
+    SignalView step;
+    SignalView time;
     const dtype dt;
 };
 
@@ -101,34 +160,38 @@ protected:
 class Reset: public Operator{
 
 public:
-    Reset(Signal dst, dtype value);
+    Reset(SignalView dst, dtype value);
     virtual string classname() const { return "Reset"; }
 
     void operator()();
+    bool lower(PlanOp& p) const;
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
-    Signal dst;
+    SignalView dst;
     const dtype value;
 };
 
 class Copy: public Operator{
 public:
-    Copy(Signal dst, Signal src);
+    Copy(SignalView dst, SignalView src);
     virtual string classname() const { return "Copy"; }
 
     void operator()();
+    bool lower(PlanOp& p) const;
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
-    Signal dst;
-    Signal src;
+    SignalView dst;
+    SignalView src;
 };
 
 class SlicedCopy: public Operator{
 public:
     SlicedCopy(
-        Signal src, Signal dst,
+        SignalView src, SignalView dst,
         int start_src, int stop_src, int step_src,
         int start_dst, int stop_dst, int step_dst,
         vector<int> seq_src, vector<int> seq_dst, bool inc);
@@ -136,10 +199,11 @@ public:
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
-    Signal src;
-    Signal dst;
+    SignalView src;
+    SignalView dst;
 
     const unsigned length_src;
     const unsigned length_dst;
@@ -157,25 +221,79 @@ protected:
 
     const bool inc;
     unsigned n_assignments;
+
+    // The indices of each assignment, resolved at build time into element
+    // offsets from src.raw_data and dst.raw_data.
+    vector<int> src_offsets;
+    vector<int> dst_offsets;
+
+    // Consecutive assignments, in order. A strided block copies n elements
+    // with constant strides starting from the offsets of its first
+    // assignment; any other block is a gather/scatter over the offsets.
+    struct Block{
+        bool strided;
+        unsigned first;
+        unsigned n;
+        int src_stride;
+        int dst_stride;
+    };
+
+    vector<Block> blocks;
+
+    // True if src and dst may overlap, in which case strided blocks
+    // can't use memcpy.
+    bool aliased;
 };
 
 
 // Increment signal Y by dot(A,X)
 class DotInc: public Operator{
 public:
-    DotInc(Signal A, Signal X, Signal Y);
+    DotInc(SignalView A, SignalView X, SignalView Y);
     virtual string classname() const { return "DotInc"; }
 
     void operator()();
+    bool lower(PlanOp& p) const;
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+    // Return an equivalent SparseDotInc if A is a matrix in which the fraction
+    // of non-zero entries is below ``threshold``, and null otherwise. The
+    // SparseDotInc keeps its own copy of A, so this is only valid if A is
+    // never written to during the simulation.
+    unique_ptr<Operator> sparsify(dtype threshold) const;
+
+    // Return an equivalent CompressedDotInc storing A in ``precision``, if
+    // this is a matrix-vector product, and null otherwise. Like sparsify,
+    // only valid if A is never written to during the simulation.
+    unique_ptr<Operator> compress(WeightPrecision precision) const;
+
+    const SignalView& get_A() const { return A; }
+    const SignalView& get_X() const { return X; }
+
+    // Return an equivalent SpikeDotInc if this is a matrix-vector product,
+    // and null otherwise. ``spikes`` must be the spike list of the neuron
+    // operator whose output is X.
+    unique_ptr<Operator> with_spikes(shared_ptr<SpikeList> spikes) const;
+
+    // Choose between the specialized small-matrix kernel (if there is one
+    // for this shape) and BLAS by timing both. By default, the kernel is
+    // only used for very small matrices.
+    void autotune();
+
+    // Matrix-vector DotIncs with the same A can be run together by a
+    // BatchedDotInc, which reads A from memory once for the whole group.
+    string merge_key() const;
+
+    friend class BatchedDotInc;
 
 protected:
     const bool scalar;
     bool matrix_vector;
 
-    Signal A;
-    Signal X;
-    Signal Y;
+    SignalView A;
+    SignalView X;
+    SignalView Y;
 
     CBLAS_TRANSPOSE transpose_A;
     CBLAS_TRANSPOSE transpose_X;
@@ -187,21 +305,124 @@ protected:
     unsigned m;
     unsigned n;
     unsigned k;
+
+    // Used instead of cblas_dgemv if not null (see small_gemv.hpp).
+    SmallGemvKernel small_kernel;
+};
+
+// A DotInc whose X is the output of a spiking neuron operator. Only the
+// columns of A for the neurons that spiked are accumulated, so a step costs
+// O(n_spikes * rows) rather than O(n_neurons * rows). Uses the dense product
+// when the spike list isn't valid, or when so many neurons spiked that the
+// dense product is faster. Results can differ from DotInc's in the last bits.
+class SpikeDotInc: public DotInc{
+public:
+    SpikeDotInc(SignalView A, SignalView X, SignalView Y, shared_ptr<SpikeList> spikes);
+    virtual string classname() const { return "SpikeDotInc"; }
+
+    void operator()();
+    bool lower(PlanOp& p) const { return false; }
+    virtual string to_string() const;
+    string merge_key() const { return ""; }
+
+protected:
+    shared_ptr<SpikeList> spikes;
+};
+
+// Increment signal Y by dot(A,X), with A stored in compressed sparse row
+// format. Created from DotIncs whose A is mostly zeros (see DotInc::sparsify).
+// Zero entries of A are skipped, so results can differ from DotInc's in the
+// last bits (if X contains infs or NaNs, the difference can be larger).
+class SparseDotInc: public Operator{
+public:
+    SparseDotInc(SignalView A, SignalView X, SignalView Y);
+    virtual string classname() const { return "SparseDotInc"; }
+
+    void operator()();
+    virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+    // Fraction of the entries of A that are non-zero.
+    static dtype density(const SignalView& A);
+
+protected:
+    SignalView X;
+    SignalView Y;
+
+    unsigned n_rows;
+    unsigned n_cols;
+
+    // Non-zero entries of row i are at positions
+    // row_offsets[i] <= k < row_offsets[i+1].
+    vector<dtype> values;
+    vector<unsigned> column_indices;
+    vector<unsigned> row_offsets;
+};
+
+// A matrix-vector DotInc that keeps its own copy of A in a reduced-precision
+// format: float16 or bfloat16 entries, or int8 entries with one scale per
+// row. Entries are expanded to double inside the dot products, so X, Y and
+// the sums stay in double precision, and only the rounding of A itself
+// changes the results. The error introduced by the rounding is measured
+// when the operator is created (see weight_error and product_error).
+class CompressedDotInc: public Operator{
+public:
+    CompressedDotInc(SignalView A, SignalView X, SignalView Y, WeightPrecision precision);
+    virtual string classname() const { return "CompressedDotInc"; }
+
+    void operator()();
+    virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+    WeightPrecision get_precision() const { return precision; }
+
+    // Bytes used to store A, and bytes that A takes as dtypes.
+    size_t compressed_bytes() const;
+    size_t original_bytes() const { return n_rows * n_cols * sizeof(dtype); }
+
+    // Largest absolute error of an entry of A, relative to the largest
+    // absolute entry of A.
+    dtype weight_error;
+
+    // Relative error (in the 2-norm) of A * x for a fixed pseudo-random
+    // non-negative x, compared to the product computed with the original A.
+    dtype product_error;
+
+protected:
+    SignalView X;
+    SignalView Y;
+
+    unsigned n_rows;
+    unsigned n_cols;
+
+    WeightPrecision precision;
+
+    // Row-major A. Only one of these is used, depending on the precision.
+    vector<uint16_t> values_16;
+    vector<int8_t> values_8;
+
+    // Only used with int8 entries; row i of A is values_8 times row_scale[i].
+    vector<dtype> row_scale;
+
+    // Expand entry k of the stored A.
+    dtype expand(size_t k, unsigned row) const;
 };
 
 
 class ElementwiseInc: public Operator{
 public:
-    ElementwiseInc(Signal A, Signal X, Signal Y);
+    ElementwiseInc(SignalView A, SignalView X, SignalView Y);
     virtual string classname() const { return "ElementwiseInc"; }
 
     void operator()();
+    bool lower(PlanOp& p) const;
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
-    Signal A;
-    Signal X;
-    Signal Y;
+    SignalView A;
+    SignalView X;
+    SignalView Y;
 
     // Strides are 0 or 1, to support broadcasting
     const unsigned A_row_stride;
@@ -214,16 +435,21 @@ protected:
 class NoDenSynapse: public Operator{
 
 public:
-    NoDenSynapse(Signal input, Signal output, dtype b);
+    NoDenSynapse(SignalView input, SignalView output, dtype b);
 
     virtual string classname() const { return "NoDenSynapse"; }
 
     void operator()();
+    bool lower(PlanOp& p) const;
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+    string merge_key() const;
+
+    friend class BatchedNoDenSynapse;
 
 protected:
-    Signal input;
-    Signal output;
+    SignalView input;
+    SignalView output;
 
     const dtype b;
 };
@@ -231,67 +457,120 @@ protected:
 class SimpleSynapse: public Operator{
 
 public:
-    SimpleSynapse(Signal input, Signal output, dtype a, dtype b);
+    SimpleSynapse(SignalView input, SignalView output, dtype a, dtype b);
 
     virtual string classname() const { return "SimpleSynapse"; }
 
     void operator()();
+    bool lower(PlanOp& p) const;
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+    string merge_key() const;
+
+    friend class BatchedSimpleSynapse;
 
 protected:
-    Signal input;
-    Signal output;
+    SignalView input;
+    SignalView output;
 
     const dtype a;
     const dtype b;
 };
 
+/* Input and output histories of a linear filter applied independently to
+ * ``n`` elements, stored as (order x n) row-major matrices with a rotating
+ * head row, so each step is a handful of passes over contiguous rows.
+ * Row k (counting from the head) holds the k-th most recent value of every
+ * element; rows that haven't been filled yet are zero. */
+class FilterHistory{
+public:
+    FilterHistory(unsigned n, const SignalView& numer, const SignalView& denom);
+
+    // Make room for the current input, and return the row to write it to,
+    // or ``scratch`` (of size n) if the filter doesn't depend on its input.
+    dtype* push_input(dtype* scratch);
+
+    // Compute the output for the current input (which must have been written
+    // to the row returned by push_input) into ``out``, which may be the
+    // ``scratch`` given to push_input, and record it in the output history.
+    void step(dtype* out);
+
+    void reset();
+
+    unsigned size() const { return n; }
+
+private:
+    unsigned n;
+
+    vector<dtype> numer;
+    vector<dtype> denom;
+
+    vector<dtype> x;
+    vector<dtype> y;
+    unsigned x_head;
+    unsigned y_head;
+};
+
 class Synapse: public Operator{
 
 public:
     Synapse(
-        Signal input, Signal output,
-        Signal numer, Signal denom);
+        SignalView input, SignalView output,
+        SignalView numer, SignalView denom);
 
     virtual string classname() const { return "Synapse"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+    string merge_key() const;
+    size_t scratch_size() const { return history.size(); }
 
     virtual void reset(unsigned seed);
 
+    friend class BatchedSynapse;
+
 protected:
-    Signal input;
-    Signal output;
+    SignalView input;
+    SignalView output;
 
-    const Signal numer;
-    const Signal denom;
+    const SignalView numer;
+    const SignalView denom;
 
-    vector< boost::circular_buffer<dtype> > x;
-    vector< boost::circular_buffer<dtype> > y;
+    FilterHistory history;
 };
 
 class TriangleSynapse: public Operator{
 
 public:
-    TriangleSynapse(Signal input, Signal output, dtype n0, dtype ndiff, unsigned n_taps);
+    TriangleSynapse(SignalView input, SignalView output, dtype n0, dtype ndiff, unsigned n_taps);
 
     virtual string classname() const { return "TriangleSynapse"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
     virtual void reset(unsigned seed);
 
 protected:
-    Signal input;
-    Signal output;
+    SignalView input;
+    SignalView output;
 
     const dtype n0;
     const dtype ndiff;
     const unsigned n_taps;
 
-    vector< boost::circular_buffer<dtype> > x;
+    // The last n_taps values of ndiff * input for each element, as an
+    // (n_taps x n_elements) row-major matrix used as a ring of rows;
+    // ``head`` is the row holding the oldest values. Unfilled rows are zero.
+    vector<dtype> taps;
+    unsigned head;
+
+    // For each element, the sum of its column of ``taps``. Kept up to date
+    // incrementally, and recomputed exactly each time ``head`` wraps around,
+    // so rounding errors can't accumulate.
+    vector<dtype> tap_sums;
 };
 
 
@@ -299,18 +578,19 @@ class WhiteNoise: public Operator{
 
 public:
     WhiteNoise(
-        Signal output, dtype mean, dtype std,
+        SignalView output, dtype mean, dtype std,
         bool do_scale, bool inc, dtype dt);
 
     virtual string classname() const { return "WhiteNoise"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
     virtual void reset(unsigned seed);
 
 protected:
-    Signal output;
+    SignalView output;
 
     const dtype mean;
     const dtype std;
@@ -329,17 +609,18 @@ protected:
 class WhiteSignal: public Operator{
 
 public:
-    WhiteSignal(Signal coefs, Signal output, Signal time, dtype dt);
+    WhiteSignal(SignalView coefs, SignalView output, SignalView time, dtype dt);
 
     virtual string classname() const { return "WhiteSignal"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
-    const Signal coefs;
-    Signal output;
-    Signal time;
+    const SignalView coefs;
+    SignalView output;
+    SignalView time;
     dtype dt;
 };
 
@@ -347,37 +628,72 @@ class PresentInput: public Operator{
 
 public:
     PresentInput(
-        Signal input, Signal output, Signal time,
+        SignalView input, SignalView output, SignalView time,
         dtype presentation_time, dtype dt);
 
     virtual string classname() const { return "PresentInput"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
-    const Signal input;
-    Signal output;
-    Signal time;
+    const SignalView input;
+    SignalView output;
+    SignalView time;
 
     dtype presentation_time;
     dtype dt;
 };
 
 
+/* Indices of the neurons that spiked in the most recent call to a spiking
+ * neuron operator, i.e. of the non-zero entries of its output. Lets operators
+ * that read the output skip the neurons that didn't spike. Not valid until
+ * the neuron operator has run since the last reset. */
+struct SpikeList{
+    SpikeList():n_spikes(0), valid(false){}
+
+    void record(const dtype* output, int stride, unsigned n);
+
+    // The first n_spikes entries are the indices of the neurons that spiked.
+    vector<unsigned> indices;
+    unsigned n_spikes;
+
+    bool valid;
+};
+
 class LIF: public Operator{
 
 public:
     LIF(
         unsigned n_neuron, dtype tau_rc, dtype tau_ref, dtype min_voltage,
-        dtype dt, Signal J, Signal output, Signal voltage,
-        Signal ref_time);
+        dtype dt, SignalView J, SignalView output, SignalView voltage,
+        SignalView ref_time);
     virtual string classname() const { return "LIF"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+    string merge_key() const;
+    virtual void reset(unsigned seed);
+
+    // Start recording the indices of spiking neurons every step, and
+    // return the list they are recorded in.
+    shared_ptr<SpikeList> get_spike_list();
+
+    const SignalView& get_output() const { return output; }
+
+    friend class BatchedLIF;
+    friend class BatchedAdaptiveLIF;
 
 protected:
+    void record_spikes(){
+        if(spikes){
+            spikes->record(output.data, output.stride1, n_neurons);
+        }
+    }
+
     const unsigned n_neurons;
 
     const dtype dt;
@@ -388,23 +704,24 @@ protected:
 
     const dtype min_voltage;
 
-    Signal J;
-    Signal output;
-    Signal voltage;
-    Signal ref_time;
+    SignalView J;
+    SignalView output;
+    SignalView voltage;
+    SignalView ref_time;
 
-    const Signal one;
-    Signal mult;
-    Signal dV;
+    const LIFParams params;
+
+    shared_ptr<SpikeList> spikes;
 };
 
 class LIFRate: public Operator{
 public:
-    LIFRate(unsigned n_neurons, dtype tau_rc, dtype tau_ref, Signal J, Signal output);
+    LIFRate(unsigned n_neurons, dtype tau_rc, dtype tau_ref, SignalView J, SignalView output);
     virtual string classname() const { return "LIFRate"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
     unsigned n_neurons;
@@ -412,28 +729,32 @@ protected:
     const dtype tau_rc;
     const dtype tau_ref;
 
-    Signal J;
-    Signal output;
+    SignalView J;
+    SignalView output;
 };
 
 class AdaptiveLIF: public LIF{
 public:
     AdaptiveLIF(
         unsigned n_neuron, dtype tau_n, dtype inc_n, dtype tau_rc, dtype tau_ref,
-        dtype min_voltage, dtype dt, Signal J, Signal output, Signal voltage,
-        Signal ref_time, Signal adaptation);
+        dtype min_voltage, dtype dt, SignalView J, SignalView output, SignalView voltage,
+        SignalView ref_time, SignalView adaptation);
     virtual string classname() const { return "AdaptiveLIF"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+    string merge_key() const;
+
+    friend class BatchedAdaptiveLIF;
 
 protected:
     const dtype tau_n;
     const dtype inc_n;
 
-    Signal adaptation;
-    Signal temp_J;
-    Signal dAdapt;
+    SignalView adaptation;
+
+    const AdaptationParams adapt_params;
 };
 
 class AdaptiveLIFRate: public LIFRate{
@@ -441,44 +762,48 @@ class AdaptiveLIFRate: public LIFRate{
 public:
     AdaptiveLIFRate(
         unsigned n_neurons, dtype tau_n, dtype inc_n, dtype tau_rc, dtype tau_ref,
-        dtype dt, Signal J, Signal output, Signal adaptation);
+        dtype dt, SignalView J, SignalView output, SignalView adaptation);
     virtual string classname() const { return "AdaptiveLIFRate"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+
+    // Room for a copy of J and the change in adaptation.
+    size_t scratch_size() const { return 2 * n_neurons; }
 
 protected:
     const dtype dt;
     const dtype tau_n;
     const dtype inc_n;
 
-    Signal adaptation;
-    Signal temp_J;
-    Signal dAdapt;
+    SignalView adaptation;
 };
 
 class RectifiedLinear: public Operator{
 public:
-    RectifiedLinear(unsigned n_neurons, Signal J, Signal output);
+    RectifiedLinear(unsigned n_neurons, SignalView J, SignalView output);
     virtual string classname() const { return "RectifiedLinear"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
     const unsigned n_neurons;
 
-    Signal J;
-    Signal output;
+    SignalView J;
+    SignalView output;
 };
 
 class Sigmoid: public Operator{
 public:
-    Sigmoid(unsigned n_neurons, dtype tau_ref, Signal J, Signal output);
+    Sigmoid(unsigned n_neurons, dtype tau_ref, SignalView J, SignalView output);
     virtual string classname() const { return "Sigmoid"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
     const unsigned n_neurons;
@@ -486,70 +811,72 @@ protected:
     const dtype tau_ref;
     const dtype tau_ref_inv;
 
-    Signal J;
-    Signal output;
+    SignalView J;
+    SignalView output;
 };
 
 class BCM: public Operator{
 public:
     BCM(
-        Signal pre_filtered, Signal post_filtered, Signal weights,
-        Signal delta, dtype learning_rate, dtype dt);
+        SignalView pre_filtered, SignalView post_filtered, SignalView weights,
+        SignalView delta, dtype learning_rate, dtype dt);
     virtual string classname() const { return "BCM"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
+    size_t scratch_size() const { return post_filtered.shape1; }
 
 protected:
     const dtype alpha;
 
-    Signal pre_filtered;
-    Signal post_filtered;
-    Signal theta;
-    Signal delta;
-
-    Signal squared_pf;
+    SignalView pre_filtered;
+    SignalView post_filtered;
+    SignalView theta;
+    SignalView delta;
 };
 
 class Oja: public Operator{
 public:
     Oja(
-        Signal pre_filtered, Signal post_filtered, Signal theta,
-        Signal delta, dtype learning_rate, dtype dt, dtype beta);
+        SignalView pre_filtered, SignalView post_filtered, SignalView theta,
+        SignalView delta, dtype learning_rate, dtype dt, dtype beta);
     virtual string classname() const { return "Oja"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
     const dtype alpha;
     const dtype beta;
 
-    Signal pre_filtered;
-    Signal post_filtered;
-    Signal weights;
-    Signal delta;
+    SignalView pre_filtered;
+    SignalView post_filtered;
+    SignalView weights;
+    SignalView delta;
 };
 
 class Voja: public Operator{
 public:
     Voja(
-        Signal pre_decoded, Signal post_filtered, Signal scaled_encoders,
-        Signal delta, Signal learning_signal, Signal scale,
+        SignalView pre_decoded, SignalView post_filtered, SignalView scaled_encoders,
+        SignalView delta, SignalView learning_signal, SignalView scale,
         dtype learning_rate, dtype dt);
     virtual string classname() const { return "Voja"; }
 
     void operator()();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
 protected:
     const dtype alpha;
 
-    Signal pre_decoded;
-    Signal post_filtered;
-    Signal scaled_encoders;
-    Signal delta;
-    Signal learning_signal;
+    SignalView pre_decoded;
+    SignalView post_filtered;
+    SignalView scaled_encoders;
+    SignalView delta;
+    SignalView learning_signal;
 
-    Signal scale;
+    SignalView scale;
 };
\ No newline at end of file
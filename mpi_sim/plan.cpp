@@ -0,0 +1,159 @@
+#include "plan.hpp"
+
+static inline void execute(PlanOp& p){
+    switch(p.type){
+        case PLAN_TIME_UPDATE:
+            p.ptr[0][0] += 1;
+            p.ptr[1][0] = p.ptr[0][0] * p.value[0];
+            break;
+
+        case PLAN_RESET:
+            fill(p.ptr[0], p.ptr[0] + p.shape[0], p.value[0]);
+            break;
+
+        case PLAN_COPY:
+            memcpy(p.ptr[0], p.ptr[1], p.shape[0] * sizeof(dtype));
+            break;
+
+        case PLAN_DOT_INC_MV:
+            cblas_xgemv(
+                CblasRowMajor, p.trans[0], p.shape[0], p.shape[1], 1.0,
+                p.ptr[0], p.stride[0], p.ptr[1], p.stride[1],
+                1.0, p.ptr[2], p.stride[2]);
+            break;
+
+        case PLAN_DOT_INC_SMALL:
+            p.kernel(
+                p.ptr[0], p.stride[0], p.shape[0], p.shape[1],
+                p.ptr[1], p.stride[1], p.ptr[2], p.stride[2]);
+            break;
+
+        case PLAN_DOT_INC_MM:
+            cblas_xgemm(
+                CblasRowMajor, p.trans[0], p.trans[1],
+                p.shape[0], p.shape[1], p.shape[2],
+                1.0, p.ptr[0], p.stride[0], p.ptr[1], p.stride[1],
+                1.0, p.ptr[2], p.stride[2]);
+            break;
+
+        case PLAN_ELEMENTWISE_INC:{
+            const dtype* A = p.ptr[0];
+            const dtype* X = p.ptr[1];
+            dtype* Y = p.ptr[2];
+
+            for(int i = 0; i < int(p.shape[0]); i++){
+                for(int j = 0; j < int(p.shape[1]); j++){
+                    Y[i * p.stride[0] + j * p.stride[1]] +=
+                        A[i * p.stride[2] + j * p.stride[3]] *
+                        X[i * p.stride[4] + j * p.stride[5]];
+                }
+            }
+            break;
+        }
+
+        case PLAN_NO_DEN_SYNAPSE:{
+            const dtype* input = p.ptr[0];
+            dtype* output = p.ptr[1];
+            const dtype b = p.value[0];
+
+            for(int i = 0; i < int(p.shape[0]); i++){
+                for(int j = 0; j < int(p.shape[1]); j++){
+                    output[i * p.stride[2] + j * p.stride[3]] =
+                        b * input[i * p.stride[0] + j * p.stride[1]];
+                }
+            }
+            break;
+        }
+
+        case PLAN_SIMPLE_SYNAPSE:{
+            const dtype* input = p.ptr[0];
+            dtype* output = p.ptr[1];
+            const dtype a = p.value[0];
+            const dtype b = p.value[1];
+
+            for(int i = 0; i < int(p.shape[0]); i++){
+                for(int j = 0; j < int(p.shape[1]); j++){
+                    dtype& out = output[i * p.stride[2] + j * p.stride[3]];
+                    out *= -a;
+                    out += b * input[i * p.stride[0] + j * p.stride[1]];
+                }
+            }
+            break;
+        }
+
+        case PLAN_VIRTUAL:
+        default:
+            (*p.op)();
+            return;
+    }
+
+    run_dbg(*p.op);
+}
+
+void ExecutionPlan::compile(const list<Operator*>& operator_list){
+    program.clear();
+    program.reserve(operator_list.size());
+
+    for(Operator* op: operator_list){
+        PlanOp p;
+        p.op = op;
+
+        if(!op->lower(p)){
+            p.type = PLAN_VIRTUAL;
+        }
+
+        program.push_back(p);
+    }
+
+    build_dbg("Compiled execution plan: " << *this);
+}
+
+void ExecutionPlan::operator()(){
+    for(PlanOp& p: program){
+        execute(p);
+    }
+}
+
+void ExecutionPlan::run_timed(double per_op_timings[]){
+    int op_index = 0;
+    for(PlanOp& p: program){
+        clock_t op_begin = clock();
+
+        execute(p);
+
+        clock_t op_end = clock();
+        per_op_timings[op_index] += double(op_end - op_begin) / CLOCKS_PER_SEC;
+
+        op_index++;
+    }
+}
+
+void ExecutionPlan::run_record(unsigned i){
+    execute(program[i]);
+}
+
+size_t ExecutionPlan::n_lowered() const{
+    size_t n = 0;
+    for(const PlanOp& p: program){
+        n += (p.type != PLAN_VIRTUAL);
+    }
+
+    return n;
+}
+
+string ExecutionPlan::to_string() const{
+    stringstream out;
+
+    out << "<ExecutionPlan" << endl;
+    out << "n_records: " << size() << endl;
+    out << "n_lowered: " << n_lowered() << endl;
+
+    for(const PlanOp& p: program){
+        out << "type: " << p.type << ", op: " << p.op->classname()
+            << ", index: " << p.op->get_index() << endl;
+    }
+
+    out << ">";
+
+    return out.str();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <ctime>
+
+#include "operator.hpp"
+
+#include "typedef.hpp"
+#include "debug.hpp"
+
+using namespace std;
+
+// Kernels that an ExecutionPlan can run directly. PLAN_VIRTUAL means
+// the record just calls back into its Operator's virtual operator().
+enum PlanOpType{
+    PLAN_VIRTUAL,
+    PLAN_TIME_UPDATE,
+    PLAN_RESET,
+    PLAN_COPY,
+    PLAN_DOT_INC_MV,
+    PLAN_DOT_INC_SMALL,
+    PLAN_DOT_INC_MM,
+    PLAN_ELEMENTWISE_INC,
+    PLAN_NO_DEN_SYNAPSE,
+    PLAN_SIMPLE_SYNAPSE
+};
+
+/* One instruction of an ExecutionPlan. All pointers and constants the kernel
+ * needs are stored inline, so running a lowered operator touches only this
+ * record and the signal data. Which fields are meaningful depends on ``type``;
+ * see Operator::lower for each operator's layout. */
+struct PlanOp{
+    PlanOpType type;
+
+    // The operator this record was lowered from. Used for the
+    // PLAN_VIRTUAL fallback and for reporting timings.
+    Operator* op;
+
+    dtype* ptr[3];
+    unsigned shape[3];
+    int stride[6];
+    dtype value[2];
+    CBLAS_TRANSPOSE trans[2];
+    SmallGemvKernel kernel;
+};
+
+/* A flat, contiguous program built from a chunk's sorted operator list.
+ * Each operator becomes exactly one PlanOp, in the same order, so
+ * per-operator timings can be indexed the same way as the operator list. */
+class ExecutionPlan{
+public:
+    ExecutionPlan(){};
+
+    void compile(const list<Operator*>& operator_list);
+    void clear(){ program.clear(); }
+
+    // Execute every record once, in order.
+    void operator()();
+
+    // Same as operator(), but accumulate the time spent
+    // in each record into ``per_op_timings``.
+    void run_timed(double per_op_timings[]);
+
+    // Execute only record ``i``. Used by ParallelExecutor, which
+    // decides the order records are run in.
+    void run_record(unsigned i);
+
+    size_t size() const { return program.size(); }
+    size_t n_lowered() const;
+
+    string to_string() const;
+
+    friend ostream& operator << (ostream &out, const ExecutionPlan &plan){
+        out << plan.to_string();
+        return out;
+    }
+
+private:
+    vector<PlanOp> program;
+};
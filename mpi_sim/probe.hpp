@@ -33,6 +33,8 @@ public:
 
     string to_string() const;
 
+    const Signal& get_signal() const { return signal; }
+
     friend ostream& operator << (ostream &out, const Probe &probe){
         out << probe.to_string();
         return out;
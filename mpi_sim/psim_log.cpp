@@ -81,7 +81,7 @@ void ParallelSimulationLog::setup_hdf5(unsigned n_steps){
 
         // Create the dataset with default properties
         dset_id = H5Dcreate(
-            file_id, dspace_key.c_str(), H5T_NATIVE_DOUBLE, dataspace_id,
+            file_id, dspace_key.c_str(), H5T_NATIVE_DTYPE, dataspace_id,
             H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 
         // Set the ``name'' attribute of the dataset so we know which probe the data came from
@@ -82,23 +82,7 @@ Signal Signal::deep_copy() const{
 }
 
 void Signal::copy_to_buffer(dtype* buffer) const{
-    if(is_contiguous){
-        memcpy(buffer, raw_data, size * sizeof(dtype));
-    }else if(stride2 == 1){
-        for(unsigned i = 0; i < shape1; i++){
-            memcpy(buffer + i * shape2,
-                   raw_data + i * stride1,
-                   shape2 * sizeof(dtype));
-        }
-    }else{
-        unsigned buffer_offset = 0;
-        for(unsigned i = 0; i < shape1; i++){
-            for(unsigned j = 0; j < shape2; j++){
-                *(buffer + buffer_offset) = operator()(i, j);
-                buffer_offset++;
-            }
-        }
-    }
+    view().copy_to_buffer(buffer);
 }
 
 Signal Signal::get_view(
@@ -121,7 +105,7 @@ Signal Signal::get_view(
     view.stride2 = stride2_;
     view.offset = offset_;
     view.is_view = true;
-    view.is_contiguous = _is_contiguous(view);
+    view.is_contiguous = view.view().is_contiguous();
     view.row_major = (stride2_ == 1);
 
     view.raw_data += offset_;
@@ -132,20 +116,66 @@ Signal Signal::get_view(
 }
 
 // ********************************************************************************
-bool _is_contiguous(const Signal signal){
-    if(signal.shape1 == 1){
-        return signal.stride2 == 1 || signal.shape2 == 1;
+void SignalView::copy_to_buffer(dtype* buffer) const{
+    if(is_contiguous()){
+        memcpy(buffer, data, size() * sizeof(dtype));
+    }else if(stride2 == 1){
+        for(unsigned i = 0; i < shape1; i++){
+            memcpy(buffer + i * shape2,
+                   data + i * stride1,
+                   shape2 * sizeof(dtype));
+        }
+    }else{
+        unsigned buffer_offset = 0;
+        for(unsigned i = 0; i < shape1; i++){
+            for(unsigned j = 0; j < shape2; j++){
+                *(buffer + buffer_offset) = operator()(i, j);
+                buffer_offset++;
+            }
+        }
+    }
+}
+
+string SignalView::to_string() const{
+    stringstream out;
+    out << "<SignalView | "
+        << " shape=" << shape_string(*this)
+        << ", stride=" << stride_string(*this)
+        << ", data=" << data;
+
+    if(RUN_DEBUG_TEST){
+        out << endl;
+        for(unsigned i = 0; i < shape1; i++){
+            out << i << ": ";
+            for(unsigned j = 0; j < shape2; j++){
+                out << operator()(i, j) << ", ";
+            }
+
+            out << endl;
+        }
     }
 
+    out << ">";
+
+    return out.str();
+}
+
+// ********************************************************************************
+bool flat_stride(const SignalView& signal, int& stride){
     if(signal.shape2 == 1){
-        return signal.stride1 == 1 || signal.shape1 == 1;
+        stride = signal.stride1;
+    }else if(signal.shape1 == 1){
+        stride = signal.stride2;
+    }else if(signal.is_contiguous() && signal.row_major()){
+        stride = 1;
+    }else{
+        return false;
     }
 
-    return (signal.stride1 == 1 && signal.stride2 == signal.shape1)
-        || (signal.stride2 == 1 && signal.stride1 == signal.shape2);
+    return true;
 }
 
-string signal_to_string(const Signal signal){
+string signal_to_string(const SignalView& signal){
 
     stringstream ss;
 
@@ -158,13 +188,13 @@ string signal_to_string(const Signal signal){
     return ss.str();
 }
 
-string shape_string(const Signal signal){
+string shape_string(const SignalView& signal){
     stringstream ss;
     ss << "(" << signal.shape1 << ", " << signal.shape2 << ")";
     return ss.str();
 }
 
-string stride_string(const Signal signal){
+string stride_string(const SignalView& signal){
     stringstream ss;
     ss << "(" << signal.stride1 << ", " << signal.stride2 << ")";
     return ss.str();
@@ -178,3 +208,53 @@ string out_of_range_message(unsigned max, unsigned idx, unsigned axis){
 
     return ss.str();
 }
+
+// ********************************************************************************
+void SignalTable::add(key_type key, const Signal& base){
+    // Nothing can point into an empty base, and in the arena it starts where
+    // the next base does, so its entry would replace that base's.
+    if(base.size == 0){
+        return;
+    }
+
+    bases[base.raw_data] = {base.raw_data + base.size, key, &base};
+}
+
+const SignalTable::Entry* SignalTable::find(const dtype* p, const dtype*& start) const{
+    auto it = bases.upper_bound(p);
+    if(it == bases.begin()){
+        return nullptr;
+    }
+
+    --it;
+    if(p >= it->second.end){
+        return nullptr;
+    }
+
+    start = it->first;
+    return &it->second;
+}
+
+const dtype* SignalTable::base_of(const dtype* p) const{
+    const dtype* start = nullptr;
+    find(p, start);
+    return start;
+}
+
+string SignalTable::describe(const SignalView& view) const{
+    stringstream ss;
+
+    const dtype* start = nullptr;
+    const Entry* entry = find(view.data, start);
+
+    if(entry){
+        const string& label = entry->signal->label;
+        ss << (label.size() > 0 ? label : "(NULL)")
+           << " (key " << entry->key << ") at offset " << view.data - start;
+    }else{
+        ss << "(unknown)";
+    }
+
+    ss << ", shape=" << shape_string(view) << ", stride=" << stride_string(view);
+    return ss.str();
+}
@@ -6,6 +6,7 @@
 #include <memory>
 #include <cstdint>
 #include <cstring>
+#include <map>
 
 #include "typedef.hpp"
 #include "debug.hpp"
@@ -15,6 +16,50 @@ using namespace std;
 
 string out_of_range_message(unsigned max, unsigned idx, unsigned axis);
 
+/* A pointer to a signal's first element plus its shape and strides. Element
+ * (i, j) is at ``data[i * stride1 + j * stride2]``. Views are trivially
+ * copyable, don't keep the data alive and never check bounds. Operators store
+ * their signals as views, while the chunk owns the base signals and keeps
+ * their labels (see SignalTable). */
+struct SignalView {
+    dtype* data;
+
+    unsigned shape1;
+    unsigned shape2;
+
+    int stride1;
+    int stride2;
+
+    dtype& operator() (unsigned row, unsigned col) const{
+        return data[int(row) * stride1 + int(col) * stride2];
+    }
+
+    // for vectors
+    dtype& operator() (unsigned idx) const{
+        return data[int(idx) * stride1];
+    }
+
+    unsigned size() const { return shape1 * shape2; }
+    bool row_major() const { return stride2 == 1; }
+    bool is_contiguous() const;
+
+    void fill_with(const SignalView& other) const;
+    void fill_with(const dtype& scalar) const;
+
+    // Copy to a buffer in row-major order.
+    void copy_to_buffer(dtype* buffer) const;
+
+    string to_string() const;
+
+    friend ostream& operator << (ostream &out, const SignalView &view){
+        out << view.to_string();
+        return out;
+    }
+};
+
+// Element access through Signal::operator() is only bounds-checked when
+// compiled with SIGNAL_BOUNDS_CHECK defined (as by ``make dbg``), since it is
+// used in the innermost loops of many operators. Signal::at() always checks.
 struct Signal {
     Signal();
 
@@ -45,6 +90,17 @@ struct Signal {
     dtype& operator() (unsigned idx);
     dtype operator() (unsigned idx) const;
 
+    // Like operator(), but always throws out_of_range for invalid indices.
+    dtype& at(unsigned row, unsigned col);
+    dtype at(unsigned row, unsigned col) const;
+    dtype& at(unsigned idx);
+    dtype at(unsigned idx) const;
+
+    SignalView view() const;
+
+    // Signals can be passed wherever a view is expected.
+    operator SignalView() const { return view(); }
+
     bool operator== (const Signal& other) const;
     bool operator!= (const Signal& other) const;
 
@@ -112,23 +168,10 @@ void Signal::fill_with(const Signal& signal){
 
 inline
 void Signal::fill_with(const dtype& scalar){
-    if(is_contiguous){
-        fill(raw_data, raw_data + size, scalar);
-    }else if(stride2 == 1){
-        for(unsigned i = 0; i < shape1; i++){
-            fill(raw_data + i * stride1, raw_data + i * stride1 + shape2, scalar);
-        }
-    }else{
-        for(unsigned i = 0; i < shape1; i++){
-            for(unsigned j = 0; j < shape2; j++){
-                operator()(i, j) = scalar;
-            }
-        }
-    }
+    view().fill_with(scalar);
 }
-
 inline
-dtype& Signal::operator() (unsigned row, unsigned col){
+dtype& Signal::at(unsigned row, unsigned col){
     if (row >= shape1){
         throw out_of_range(out_of_range_message(shape1, row, 0));
     }
@@ -141,21 +184,13 @@ dtype& Signal::operator() (unsigned row, unsigned col){
 }
 
 inline
-dtype Signal::operator() (unsigned row, unsigned col) const{
-    if (row >= shape1){
-        throw out_of_range(out_of_range_message(shape1, row, 0));
-    }
-
-    if (col >= shape2){
-        throw out_of_range(out_of_range_message(shape2, col, 1));
-    }
-
-    return *(raw_data + int(row) * stride1 + int(col) * stride2);
+dtype Signal::at(unsigned row, unsigned col) const{
+    return const_cast<Signal*>(this)->at(row, col);
 }
 
 // for dealing with vectors.
 inline
-dtype& Signal::operator() (unsigned idx){
+dtype& Signal::at(unsigned idx){
     if (idx >= shape1){
         throw out_of_range(out_of_range_message(shape1, idx, 0));
     }
@@ -163,15 +198,117 @@ dtype& Signal::operator() (unsigned idx){
     return *(raw_data + int(idx) * stride1);
 }
 
+inline
+dtype Signal::at(unsigned idx) const{
+    return const_cast<Signal*>(this)->at(idx);
+}
+
+#ifdef SIGNAL_BOUNDS_CHECK
+
+inline
+dtype& Signal::operator() (unsigned row, unsigned col){
+    return at(row, col);
+}
+
+inline
+dtype Signal::operator() (unsigned row, unsigned col) const{
+    return at(row, col);
+}
+
+inline
+dtype& Signal::operator() (unsigned idx){
+    return at(idx);
+}
+
 inline
 dtype Signal::operator() (unsigned idx) const{
-    if (idx >= shape1){
-        throw out_of_range(out_of_range_message(shape1, idx, 0));
-    }
+    return at(idx);
+}
+
+#else
 
+inline
+dtype& Signal::operator() (unsigned row, unsigned col){
+    return *(raw_data + int(row) * stride1 + int(col) * stride2);
+}
+
+inline
+dtype Signal::operator() (unsigned row, unsigned col) const{
+    return *(raw_data + int(row) * stride1 + int(col) * stride2);
+}
+
+inline
+dtype& Signal::operator() (unsigned idx){
     return *(raw_data + int(idx) * stride1);
 }
 
+inline
+dtype Signal::operator() (unsigned idx) const{
+    return *(raw_data + int(idx) * stride1);
+}
+
+#endif
+
+inline
+SignalView Signal::view() const{
+    return {raw_data, shape1, shape2, stride1, stride2};
+}
+
+inline
+bool SignalView::is_contiguous() const{
+    if(shape1 == 1){
+        return stride2 == 1 || shape2 == 1;
+    }
+
+    if(shape2 == 1){
+        return stride1 == 1;
+    }
+
+    return (stride1 == 1 && stride2 == int(shape1))
+        || (stride2 == 1 && stride1 == int(shape2));
+}
+
+inline
+void SignalView::fill_with(const SignalView& other) const{
+
+    if(shape1 != other.shape1 || shape2 != other.shape2){
+        stringstream out;
+        out << "Shape mismatch in SignalView.fill_with. "
+            << "Attempting to fill " << endl
+            << *this << endl
+            << " with " << endl
+            << other << endl;
+        throw runtime_error(out.str());
+    }
+
+    if(is_contiguous()){
+        other.copy_to_buffer(data);
+    }else{
+        for(unsigned i = 0; i < shape1; i++){
+            for(unsigned j = 0; j < shape2; j++){
+                operator()(i, j) = other(i, j);
+            }
+        }
+    }
+}
+
+inline
+void SignalView::fill_with(const dtype& scalar) const{
+    if(is_contiguous()){
+        fill(data, data + size(), scalar);
+    }else if(stride2 == 1){
+        for(unsigned i = 0; i < shape1; i++){
+            fill(data + i * stride1, data + i * stride1 + shape2, scalar);
+        }
+    }else{
+        for(unsigned i = 0; i < shape1; i++){
+            for(unsigned j = 0; j < shape2; j++){
+                operator()(i, j) = scalar;
+            }
+        }
+    }
+}
+
 inline
 bool Signal::operator== (const Signal& other) const{
     bool identical = true;
@@ -198,8 +335,43 @@ bool Signal::operator!= (const Signal& other) const{
     return !(*this == other);
 }
 
-bool _is_contiguous(const Signal signal);
-
-string signal_to_string(const Signal signal);
-string shape_string(const Signal signal);
-string stride_string(const Signal signal);
+// Check whether visiting the elements of ``signal`` in row-major order amounts
+// to stepping through memory with a fixed stride. If so, store that stride.
+bool flat_stride(const SignalView& signal, int& stride);
+
+string signal_to_string(const SignalView& signal);
+string shape_string(const SignalView& signal);
+string stride_string(const SignalView& signal);
+
+/* Index of the base signals of a chunk by address. Operators only hold
+ * SignalViews, so build-time passes use this to find out which base signal
+ * (and which label) a view belongs to. Refers to the base signals that were
+ * added, so it's only valid as long as they aren't moved or freed. */
+class SignalTable{
+public:
+    // Empty base signals are not added.
+    void add(key_type key, const Signal& base);
+    void clear(){ bases.clear(); }
+
+    // Start of the buffer of the base signal that ``p`` points into, or null
+    // if it doesn't point into any of them.
+    const dtype* base_of(const dtype* p) const;
+
+    // Describe ``view`` by the label of its base signal and its position in
+    // the base signal, for debugging output.
+    string describe(const SignalView& view) const;
+
+    unsigned size() const { return bases.size(); }
+
+private:
+    struct Entry{
+        const dtype* end;
+        key_type key;
+        const Signal* signal;
+    };
+
+    // Keyed by the start of each base signal's buffer.
+    map<const dtype*, Entry> bases;
+
+    const Entry* find(const dtype* p, const dtype*& start) const;
+};
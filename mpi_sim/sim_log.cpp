@@ -47,7 +47,7 @@ void SimulationLog::setup_hdf5(unsigned n_steps){
 
         // Create the dataset with default properties
         dset_id = H5Dcreate2(
-            file_id, dspace_key.c_str(), H5T_NATIVE_DOUBLE, dataspace_id,
+            file_id, dspace_key.c_str(), H5T_NATIVE_DTYPE, dataspace_id,
             H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 
         // Set the ``name'' attribute of the dataset so we know which probe the data came from
@@ -85,7 +85,7 @@ void SimulationLog::write(key_type probe_key, shared_ptr<dtype> buffer, unsigned
         d.dataspace_id, H5S_SELECT_SET, offset, stride, count, block);
 
     status = H5Dwrite(
-        d.dset_id, H5T_NATIVE_DOUBLE, memspace_id, d.dataspace_id,
+        d.dset_id, H5T_NATIVE_DTYPE, memspace_id, d.dataspace_id,
         d.plist_id, buffer.get());
 
     H5Sclose(memspace_id);
@@ -1,8 +1,8 @@
 #include "simulator.hpp"
 
-Simulator::Simulator(bool collect_timings)
-:collect_timings(collect_timings){
-    chunk = unique_ptr<MpiSimulatorChunk>(new MpiSimulatorChunk(collect_timings));
+Simulator::Simulator(bool collect_timings, SimulatorConfig config)
+:collect_timings(collect_timings), config(config){
+    chunk = unique_ptr<MpiSimulatorChunk>(new MpiSimulatorChunk(collect_timings, config));
 }
 
 void Simulator::from_file(string filename){
@@ -14,6 +14,7 @@
 #include "operator.hpp"
 #include "chunk.hpp"
 #include "spec.hpp"
+#include "config.hpp"
 
 #include "typedef.hpp"
 #include "debug.hpp"
@@ -23,7 +24,7 @@ using namespace std;
 class Simulator{
 
 public:
-    Simulator(bool collect_timings);
+    Simulator(bool collect_timings, SimulatorConfig config=SimulatorConfig());
 
     virtual ~Simulator(){};
 
@@ -68,6 +69,7 @@ public:
 protected:
     unique_ptr<MpiSimulatorChunk> chunk;
     bool collect_timings;
+    SimulatorConfig config;
     string label;
 
     // Place to store probe data retrieved from worker
@@ -0,0 +1,144 @@
+#include "small_gemv.hpp"
+
+// Number of calls of each implementation timed by small_gemv_is_faster.
+#define SMALL_GEMV_TUNE_REPS 200
+
+// A with N columns: one dot product of length N per row.
+template<unsigned N>
+static void gemv_few_cols(
+        const dtype* A, int lda, unsigned m, unsigned n,
+        const dtype* x, int x_stride, dtype* y, int y_stride){
+
+    dtype x_local[N];
+    for(unsigned j = 0; j < N; j++){
+        x_local[j] = x[int(j) * x_stride];
+    }
+
+    for(unsigned i = 0; i < m; i++){
+        const dtype* a = A + int(i) * lda;
+
+        dtype sum = 0.0;
+        for(unsigned j = 0; j < N; j++){
+            sum += a[j] * x_local[j];
+        }
+
+        y[int(i) * y_stride] += sum;
+    }
+}
+
+// A with M rows: M dot products accumulated side by side, in a single pass
+// over x. Each keeps 4 partial sums, so that the compiler can use vector
+// instructions when x is contiguous.
+template<unsigned M>
+static void gemv_few_rows(
+        const dtype* A, int lda, unsigned m, unsigned n,
+        const dtype* x, int x_stride, dtype* y, int y_stride){
+
+    dtype sum[M][4] = {};
+
+    unsigned n_vec = x_stride == 1 ? n - n % 4 : 0;
+
+    for(unsigned j = 0; j < n_vec; j += 4){
+        for(unsigned i = 0; i < M; i++){
+            const dtype* a = A + int(i) * lda + int(j);
+            for(unsigned l = 0; l < 4; l++){
+                sum[i][l] += a[l] * x[j + l];
+            }
+        }
+    }
+
+    for(unsigned j = n_vec; j < n; j++){
+        dtype x_j = x[int(j) * x_stride];
+
+        for(unsigned i = 0; i < M; i++){
+            sum[i][0] += A[int(i) * lda + int(j)] * x_j;
+        }
+    }
+
+    for(unsigned i = 0; i < M; i++){
+        y[int(i) * y_stride] += (sum[i][0] + sum[i][1]) + (sum[i][2] + sum[i][3]);
+    }
+}
+
+// Tables of kernels, indexed by the small dimension.
+template<unsigned D>
+struct SmallGemvTable{
+    static void fill(SmallGemvKernel few_cols[], SmallGemvKernel few_rows[]){
+        few_cols[D] = gemv_few_cols<D>;
+        few_rows[D] = gemv_few_rows<D>;
+        SmallGemvTable<D - 1>::fill(few_cols, few_rows);
+    }
+};
+
+template<>
+struct SmallGemvTable<0>{
+    static void fill(SmallGemvKernel few_cols[], SmallGemvKernel few_rows[]){
+        few_cols[0] = nullptr;
+        few_rows[0] = nullptr;
+    }
+};
+
+SmallGemvKernel select_small_gemv(unsigned m, unsigned n){
+    static SmallGemvKernel few_cols[SMALL_GEMV_MAX_DIM + 1];
+    static SmallGemvKernel few_rows[SMALL_GEMV_MAX_DIM + 1];
+    static bool filled = false;
+
+    if(!filled){
+        SmallGemvTable<SMALL_GEMV_MAX_DIM>::fill(few_cols, few_rows);
+        filled = true;
+    }
+
+    if(n <= SMALL_GEMV_MAX_DIM){
+        return few_cols[n];
+    }
+
+    if(m <= SMALL_GEMV_MAX_DIM){
+        return few_rows[m];
+    }
+
+    return nullptr;
+}
+
+bool small_gemv_is_faster(unsigned m, unsigned n){
+    static map<pair<unsigned, unsigned>, bool> cache;
+
+    auto shape = make_pair(m, n);
+    auto cached = cache.find(shape);
+    if(cached != cache.end()){
+        return cached->second;
+    }
+
+    SmallGemvKernel kernel = select_small_gemv(m, n);
+    if(!kernel){
+        cache[shape] = false;
+        return false;
+    }
+
+    vector<dtype> A(m * n), x(n), y(m, 0.0);
+    for(unsigned i = 0; i < m * n; i++){
+        A[i] = dtype(i % 7) - 3.0;
+    }
+    for(unsigned j = 0; j < n; j++){
+        x[j] = dtype(j % 5) * 0.25;
+    }
+
+    // Run each once first, so neither pays for bringing A into cache.
+    kernel(A.data(), n, m, n, x.data(), 1, y.data(), 1);
+    cblas_xgemv(CblasRowMajor, CblasNoTrans, m, n, 1.0, A.data(), n, x.data(), 1, 1.0, y.data(), 1);
+
+    auto start = chrono::steady_clock::now();
+    for(unsigned r = 0; r < SMALL_GEMV_TUNE_REPS; r++){
+        kernel(A.data(), n, m, n, x.data(), 1, y.data(), 1);
+    }
+    auto kernel_end = chrono::steady_clock::now();
+
+    for(unsigned r = 0; r < SMALL_GEMV_TUNE_REPS; r++){
+        cblas_xgemv(CblasRowMajor, CblasNoTrans, m, n, 1.0, A.data(), n, x.data(), 1, 1.0, y.data(), 1);
+    }
+    auto blas_end = chrono::steady_clock::now();
+
+    bool faster = (kernel_end - start) < (blas_end - kernel_end);
+    cache[shape] = faster;
+
+    return faster;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+#include <utility>
+#include <vector>
+#include <chrono>
+
+#include <cblas.h>
+
+#include "typedef.hpp"
+
+using namespace std;
+
+// Kernels for y += A * x, where A is row-major and has only a few rows (as
+// for the decoders of low-dimensional ensembles) or only a few columns (as
+// for their encoders). At these sizes the fixed cost of a call to
+// cblas_dgemv dominates. The small dimension is a template parameter, so
+// the loops over it are fully unrolled.
+//
+// Results can differ from cblas_dgemv's in the last bits, since the order
+// in which products are summed is different.
+
+// Largest number of rows or columns that has a specialized kernel.
+const unsigned SMALL_GEMV_MAX_DIM = 16;
+
+// Unless kernels are autotuned, they are only used for matrices with at most
+// this many elements, where the overhead of calling BLAS clearly dominates.
+const unsigned SMALL_GEMV_DEFAULT_MAX_SIZE = 128;
+
+/* Element i of x is at x[i * x_stride], and similarly for y. */
+typedef void (*SmallGemvKernel)(
+    const dtype* A, int lda, unsigned m, unsigned n,
+    const dtype* x, int x_stride, dtype* y, int y_stride);
+
+/* Return the kernel for an m x n row-major A, or null if neither
+ * dimension is small enough. */
+SmallGemvKernel select_small_gemv(unsigned m, unsigned n);
+
+/* Time the kernel for an m x n matrix against cblas_dgemv on scratch data,
+ * and return true if the kernel is faster. Results are cached, so each shape
+ * is only timed once per process. */
+bool small_gemv_is_faster(unsigned m, unsigned n);
@@ -55,6 +55,13 @@ void SpaunStimulus::operator() (){
     }
 }
 
+bool SpaunStimulus::get_accesses(vector<SignalAccess>& accesses) const{
+    accesses.push_back(SignalAccess(t, ACCESS_READ));
+    accesses.push_back(SignalAccess(output, ACCESS_SET));
+
+    return true;
+}
+
 string SpaunStimulus::to_string() const{
     stringstream out;
 
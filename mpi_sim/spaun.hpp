@@ -32,6 +32,7 @@ public:
 
     void operator() ();
     virtual string to_string() const;
+    bool get_accesses(vector<SignalAccess>& accesses) const;
 
     virtual void reset(unsigned seed);
 
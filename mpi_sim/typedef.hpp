@@ -1,7 +1,47 @@
+#include <cstdint>
+
 /* Type of keys for various maps in the MpiSimulatorChunk. Keys are typically
  * addresses of python objects, so we need to use long long ints (64 bits). */
 typedef uintmax_t key_type;
 
-/* Type for data used throughout the simulation. */
+/* Type for data used throughout the simulation. Building with
+ * SINGLE_PRECISION defined (``make single``) uses floats instead of doubles,
+ * which halves the memory used by signals and the size of MPI messages.
+ * Network files always store doubles; they are converted when loaded.
+ *
+ * The names of the corresponding MPI, HDF5 and numpy types and of the BLAS
+ * routines are given by macros, which only have to be valid where they're
+ * used. */
+#ifdef SINGLE_PRECISION
+
+typedef float dtype;
+
+#define MPI_DTYPE MPI_FLOAT
+#define H5T_NATIVE_DTYPE H5T_NATIVE_FLOAT
+#define NPY_DTYPE NPY_FLOAT32
+#define DTYPE_NAME "float32"
+
+#define cblas_xgemv cblas_sgemv
+#define cblas_xgemm cblas_sgemm
+#define cblas_xger cblas_sger
+#define cblas_xcopy cblas_scopy
+#define cblas_xaxpy cblas_saxpy
+#define cblas_xscal cblas_sscal
+
+#else
+
 typedef double dtype;
 
+#define MPI_DTYPE MPI_DOUBLE
+#define H5T_NATIVE_DTYPE H5T_NATIVE_DOUBLE
+#define NPY_DTYPE NPY_FLOAT64
+#define DTYPE_NAME "float64"
+
+#define cblas_xgemv cblas_dgemv
+#define cblas_xgemm cblas_dgemm
+#define cblas_xger cblas_dger
+#define cblas_xcopy cblas_dcopy
+#define cblas_xaxpy cblas_daxpy
+#define cblas_xscal cblas_dscal
+
+#endif
@@ -3,7 +3,10 @@
 The worker processes enter the C++ code and wait for signals from the master
 process. The master process executes the script given as the first argument.
 
-Example usage: mpirun -np <np> python -m nengo_mpi <script>
+Example usage: mpirun -np <np> python -m nengo_mpi [--hybrid] <script>
+
+With --hybrid, MPI is initialized with MPI_THREAD_MULTIPLE, as required by
+the ``hybrid`` option of nengo_mpi.Simulator's ``sim_options``.
 
 This code is only executed if nengo_mpi is run as the main script with -m.
 
@@ -25,15 +28,19 @@ def main():
     import ctypes
     ctypes.CDLL("libmpi.so", mode=ctypes.RTLD_GLOBAL)
 
+    hybrid = sys.argv[1:2] == ["--hybrid"]
+    if hybrid:
+        del sys.argv[1]
+
     import mpi_sim
-    mpi_sim.init()
+    mpi_sim.init(int(hybrid))
 
     rank = mpi_sim.get_rank()
     n_procs = mpi_sim.get_n_procs()
 
     if rank == 0 and (not sys.argv[1:] or sys.argv[1] in ("--help", "-h")):
         print_("usage: mpirun -np <np> "
-               "python -m nengo_mpi scriptfile [arg] ...")
+               "python -m nengo_mpi [--hybrid] scriptfile [arg] ...")
         sys.exit(2)
 
     if rank > 0:
@@ -261,11 +261,14 @@ class MpiModel(Model):
     debug: bool
         Whether to run in debug mode. In debug mode, labels of operators and
         strings are passed to C++.
+    sim_options: dict
+        Options for the native simulator; see ``nengo_mpi.Simulator``.
 
     """
     def __init__(
             self, n_components, assignments, dt=0.001, label=None,
-            decoder_cache=NoDecoderCache(), save_file="", debug=False):
+            decoder_cache=NoDecoderCache(), save_file="", debug=False,
+            sim_options=None):
 
         self.dt = dt
         self.label = label
@@ -320,7 +323,8 @@ class MpiModel(Model):
                 "argument was empty.")
 
         # Only create a working simulator if necessary.
-        self.native_sim = NativeSimulator(self.sig) if not save_file else None
+        self.native_sim = (
+            NativeSimulator(self.sig, sim_options) if not save_file else None)
 
         self.save_file = save_file if save_file else tempfile.mktemp()
 
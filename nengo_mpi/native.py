@@ -27,19 +27,23 @@ class NativeSimulator(object):
     Talks to the native simulator using ctypes.
 
     """
-    def __init__(self, sig):
+    def __init__(self, sig, sim_options=None):
         if not native_sim_available():
             raise Exception(
                 "Created NativeSimulator, but mpi_sim.so is not available.")
 
         self.sig = sig
 
+        # Type of the simulator's signal data. Buffers that are shared with
+        # the native simulator must have this type.
+        self.dtype = np.dtype(mpi_sim.dtype)
+
         self.callbacks = []
         self.time_buffers = []
         self.input_buffers = []
         self.output_buffers = []
 
-        mpi_sim.create_simulator()
+        mpi_sim.create_simulator(**(sim_options or {}))
 
     def load_network(self, filename):
         assert isinstance(filename,
@@ -82,7 +86,7 @@ class NativeSimulator(object):
         pass_time = op.t is not None
         t_signal = op.t if pass_time else self.sig['common'][0]
         t_string = signal_to_string(t_signal)
-        time_buffer = np.array([22.0])
+        time_buffer = np.array([22.0], dtype=self.dtype)
         self.time_buffers.append(time_buffer)
 
         # Handle input.
@@ -90,9 +94,9 @@ class NativeSimulator(object):
         input_signal = op.x if pass_input else self.sig['common'][0]
         input_string = signal_to_string(input_signal)
         if not input_signal.shape:
-            input_buffer = np.array([0.0])
+            input_buffer = np.array([0.0], dtype=self.dtype)
         else:
-            input_buffer = input_signal.initial_value.copy()
+            input_buffer = input_signal.initial_value.astype(self.dtype)
         self.input_buffers.append(input_buffer)
 
         # Handle output.
@@ -101,9 +105,9 @@ class NativeSimulator(object):
             op.output if return_output else self.sig['common']['NULL'])
         output_string = signal_to_string(output_signal)
         if not output_signal:
-            output_buffer = np.array([0.0])
+            output_buffer = np.array([0.0], dtype=self.dtype)
         else:
-            output_buffer = output_signal.initial_value.copy()
+            output_buffer = output_signal.initial_value.astype(self.dtype)
         self.output_buffers.append(output_buffer)
 
         def py_func():
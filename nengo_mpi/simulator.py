@@ -25,7 +25,8 @@ class Simulator(nengo.Simulator):
 
     def __init__(
             self, network, dt=0.001, seed=None, model=None,
-            partitioner=None, assignments=None, save_file=""):
+            partitioner=None, assignments=None, save_file="",
+            sim_options=None):
         """ A simulator that can be executed in parallel using MPI.
 
         Parameters
@@ -57,6 +58,18 @@ class Simulator(nengo.Simulator):
             Name of file that will store all data added to the simulator.
             The simulator can later be reconstructed from this file. If
             equal to the empty string, then no file is created.
+        sim_options: dict
+            Options for the native simulator, as keyword arguments. How its
+            chunks communicate: ``transport`` ('two-sided', 'rma' or
+            'neighbor'), ``aggregate_messages``, ``persistent_requests`` and
+            ``zero_copy_size``. How each chunk runs its operators:
+            ``use_plan``, ``n_threads``, ``hybrid`` and ``autotune``. These
+            correspond to the --transport, --noaggregate, --nopersistent,
+            --zerocopy, --noplan, --threads, --hybrid and --autotune options
+            of the nengo_mpi executable.
+            Anything not given keeps its default. With ``hybrid``, the
+            script should be run with ``python -m nengo_mpi --hybrid``, so
+            that MPI is initialized with MPI_THREAD_MULTIPLE.
 
         """
         print("Beginning build of MPI model...")
@@ -92,7 +105,7 @@ class Simulator(nengo.Simulator):
             self.n_components, self.assignments, dt=dt,
             label="%s, dt=%f" % (network, dt),
             decoder_cache=get_default_decoder_cache(),
-            save_file=save_file)
+            save_file=save_file, sim_options=sim_options)
 
         print("    Calling build...")
         MpiBuilder.build(self.model, network)
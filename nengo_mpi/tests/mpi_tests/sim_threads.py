@@ -0,0 +1,91 @@
+"""
+Test running each chunk's operators on several threads (the ``n_threads``
+option in the ``sim_options`` argument of nengo_mpi.Simulator) against the
+reference implementation, for each transport, for a first run and for a
+second run after a reset. The network has Nodes, LIF ensembles and
+connections between them, and connections cross component boundaries both
+with a synapse (updates) and without one, so each chunk's MPI operators are
+run by its thread pool as well.
+
+Given --hybrid (run with ``python -m nengo_mpi --hybrid sim_threads.py
+--hybrid``), the simulators are run in hybrid mode.
+
+"""
+
+import sys
+
+import nengo
+import nengo_mpi
+from nengo_mpi.partition import work_balanced_partitioner
+
+import numpy as np
+
+n_neurons = 40
+
+rng = np.random.RandomState(2)
+sequence = rng.random_sample((1000, 3))
+
+
+def f(t):
+    return sequence[int(t * 1000) % 1000]
+
+
+m = nengo.Network(seed=1)
+with m:
+    ensembles = [
+        nengo.Ensemble(n_neurons, dimensions=3, neuron_type=nengo.LIF())
+        for i in range(4)]
+
+    nengo.Connection(ensembles[0], ensembles[1], synapse=None)
+    nengo.Connection(ensembles[1], ensembles[2], synapse=0.05)
+    nengo.Connection(ensembles[2], ensembles[3], synapse=None)
+    nengo.Connection(ensembles[3], ensembles[0], synapse=0.02)
+    nengo.Connection(
+        ensembles[0].neurons, ensembles[2].neurons,
+        transform=0.01 * rng.randn(n_neurons, n_neurons), synapse=0.01)
+
+    input = nengo.Node(f)
+    nengo.Connection(input, ensembles[0], synapse=None)
+
+    output = nengo.Node(size_in=3)
+    nengo.Connection(ensembles[3], output, synapse=0.01)
+
+    probes = [nengo.Probe(e) for e in ensembles] + [nengo.Probe(output)]
+
+sim_time = 0.2
+
+refimpl_sim = nengo.Simulator(m)
+refimpl_sim.run(sim_time)
+
+hybrid = '--hybrid' in sys.argv[1:]
+
+variants = [
+    dict(n_threads=4, hybrid=hybrid, transport=transport)
+    for transport in ['two-sided', 'rma', 'neighbor']]
+
+for sim_options in variants:
+    partitioner = nengo_mpi.Partitioner(
+        4, cross_at_updates=False, func=work_balanced_partitioner)
+    sim = nengo_mpi.Simulator(
+        m, partitioner=partitioner, sim_options=sim_options)
+
+    try:
+        components = set(
+            partitioner.object_assignments[e] for e in ensembles)
+        assert len(components) > 1
+
+        sim.run(sim_time)
+        first_run = [np.array(sim.data[p]) for p in probes]
+
+        sim.reset()
+        sim.run(sim_time)
+
+        for p, data in zip(probes, first_run):
+            assert np.allclose(
+                refimpl_sim.data[p], data,
+                atol=0.00001, rtol=0.00), sim_options
+            assert np.allclose(
+                refimpl_sim.data[p], sim.data[p],
+                atol=0.00001, rtol=0.00), sim_options
+    finally:
+        sim.close()
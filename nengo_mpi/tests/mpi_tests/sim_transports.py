@@ -0,0 +1,74 @@
+"""
+Test each way of transferring messages between chunks (see the
+``sim_options`` argument of nengo_mpi.Simulator) against the reference
+implementation, for a first run and for a second run after a reset.
+Connections cross component boundaries both with a synapse (updates) and
+without one.
+
+"""
+
+import nengo
+import nengo_mpi
+from nengo_mpi.partition import work_balanced_partitioner
+
+import numpy as np
+
+n_neurons = 40
+
+m = nengo.Network(seed=1)
+with m:
+    ensembles = [
+        nengo.Ensemble(n_neurons, dimensions=3) for i in range(4)]
+
+    nengo.Connection(ensembles[0], ensembles[1], synapse=None)
+    nengo.Connection(ensembles[1], ensembles[2], synapse=0.05)
+    nengo.Connection(ensembles[2], ensembles[3], synapse=None)
+    nengo.Connection(ensembles[2], ensembles[1], synapse=0.01)
+    nengo.Connection(ensembles[3], ensembles[0], synapse=0.02)
+
+    probes = [nengo.Probe(e) for e in ensembles]
+
+    input = nengo.Node([0.1, 0.2, -0.3])
+    nengo.Connection(input, ensembles[0], synapse=None)
+
+sim_time = 0.2
+
+refimpl_sim = nengo.Simulator(m)
+refimpl_sim.run(sim_time)
+
+variants = []
+for transport in ['two-sided', 'rma', 'neighbor']:
+    variants.extend([
+        dict(transport=transport),
+        dict(transport=transport, aggregate_messages=False),
+        dict(transport=transport, persistent_requests=False),
+        dict(transport=transport, zero_copy_size=1),
+        dict(transport=transport, aggregate_messages=False,
+             persistent_requests=False, zero_copy_size=1)])
+
+for sim_options in variants:
+    partitioner = nengo_mpi.Partitioner(
+        4, cross_at_updates=False, func=work_balanced_partitioner)
+    sim = nengo_mpi.Simulator(
+        m, partitioner=partitioner, sim_options=sim_options)
+
+    try:
+        components = set(
+            partitioner.object_assignments[e] for e in ensembles)
+        assert len(components) > 1
+
+        sim.run(sim_time)
+        first_run = [np.array(sim.data[p]) for p in probes]
+
+        sim.reset()
+        sim.run(sim_time)
+
+        for p, data in zip(probes, first_run):
+            assert np.allclose(
+                refimpl_sim.data[p], data,
+                atol=0.00001, rtol=0.00), sim_options
+            assert np.allclose(
+                refimpl_sim.data[p], sim.data[p],
+                atol=0.00001, rtol=0.00), sim_options
+    finally:
+        sim.close()
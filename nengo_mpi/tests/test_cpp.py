@@ -1,4 +1,5 @@
 import os
+import re
 import subprocess
 import pytest
 import h5py
@@ -65,3 +66,82 @@ def test_basic_cpp(neuron_type, synapse):
         refimpl_sim.data[A_p], results[str(id(A_p))], atol=0.00001, rtol=0.00)
     assert np.allclose(
         refimpl_sim.data[B_p], results[str(id(B_p))], atol=0.00001, rtol=0.00)
+
+
+def weights_transform(case):
+    rng = np.random.RandomState(5)
+    transform = rng.uniform(-1, 1, (8, 5))
+
+    if case == 'subnormal':
+        # Below the smallest normal float16, 2^-14.
+        transform[1] *= 1e-6
+        transform[2, :2] = [3e-8, -5e-7]
+    elif case == 'overflow':
+        # Above the largest float16, 65504.
+        transform[3, 1] = 1e5
+        transform[5, 4] = -7e4
+    elif case == 'zero_row':
+        transform[4] = 0.0
+
+    return transform
+
+
+@pytest.mark.parametrize("precision", ['float16', 'bfloat16', 'int8'])
+@pytest.mark.parametrize("case", ['subnormal', 'overflow', 'zero_row'])
+def test_weights_cpp(precision, case):
+    """
+    Test that a transform stored in reduced precision (--weights) stays
+    within the error that nengo_cpp reports for the entries of the matrix.
+    """
+    transform = weights_transform(case)
+    x = np.linspace(0.1, 1.0, transform.shape[1])
+
+    m = nengo.Network(seed=1)
+    with m:
+        input = nengo.Node(x)
+        output = nengo.Node(size_in=transform.shape[0])
+        nengo.Connection(input, output, transform=transform, synapse=None)
+
+        probe = nengo.Probe(output)
+
+    sim_time = 0.1
+
+    refimpl_sim = nengo.Simulator(m)
+    refimpl_sim.run(sim_time)
+
+    network_file = "test_nengo.net"
+    log_file = "test_nengo.h5"
+
+    try:
+        nengo_mpi.Simulator(m, save_file=network_file)
+        report = subprocess.check_output(
+            ['nengo_cpp', '--noprog', '--weights', precision,
+             '--log', log_file, network_file, str(sim_time)])
+
+        with h5py.File(log_file, 'r') as results:
+            cpp_data = np.array(results[str(id(probe))])
+    finally:
+        try:
+            os.remove(network_file)
+        except:
+            pass
+
+        try:
+            os.remove(log_file)
+        except:
+            pass
+
+    match = re.search(
+        r"relative to the largest entry\): (\S+?)\. Largest",
+        report.decode())
+    assert match is not None
+    weight_error = float(match.group(1))
+
+    # Each entry of A is off by at most weight_error * max|A|, so each entry
+    # of A * x is off by at most that times the 1-norm of x. The report
+    # rounds weight_error to 6 significant digits.
+    bound = 1.00001 * weight_error * np.abs(transform).max() * np.abs(x).sum()
+
+    assert np.isfinite(cpp_data).all()
+    assert np.allclose(
+        refimpl_sim.data[probe], cpp_data, atol=bound + 1e-9, rtol=0.0)
@@ -57,6 +57,25 @@ def test_mpi_script(n_processors, script_name):
             "\n\nOutput:\n" + output)
 
 
+@pytest.mark.parametrize("n_processors", [1, 4])
+def test_hybrid(n_processors):
+    """ Run mpi_tests/sim_threads.py in hybrid mode, with MPI initialized
+    with MPI_THREAD_MULTIPLE by ``python -m nengo_mpi --hybrid``.
+
+    """
+    script_name = os.path.join(mpi_test_script_dir, "sim_threads.py")
+    output, exit_code = run_python_mpi(
+        n_processors, script_name, ["--hybrid"], ["--hybrid"])
+    print(output)
+
+    if n_processors > 1:
+        assert "Running in hybrid mode with 4 thread(s) per process." in output
+
+    assert not exit_code, (
+        "Script exited with non-zero exit status."
+        "\n\nOutput:\n" + output)
+
+
 all_neurons = [
     LIF, LIFRate, RectifiedLinear, Sigmoid,
     AdaptiveLIF, AdaptiveLIFRate]  # Izhikevich]
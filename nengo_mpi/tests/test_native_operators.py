@@ -47,9 +47,13 @@ class _TestSimulator(nengo_mpi.Simulator):
         List of python operators.
     signal_probes: list
         List of SignalProbes.
+    sim_options: dict
+        Options for the native simulator; see ``nengo_mpi.Simulator``.
 
     """
-    def __init__(self, operators, signal_probes, dt=0.001, seed=None):
+    def __init__(
+            self, operators, signal_probes, dt=0.001, seed=None,
+            sim_options=None):
 
         if self._open_simulators:
             raise RuntimeError(
@@ -62,7 +66,9 @@ class _TestSimulator(nengo_mpi.Simulator):
         assignments = defaultdict(int)
 
         print("Building MPI model...")
-        self.model = MpiModel(1, assignments, dt=dt, label="_TestSimulator")
+        self.model = MpiModel(
+            1, assignments, dt=dt, label="_TestSimulator",
+            sim_options=sim_options)
 
         self.model.assign_ops(0, operators)
 
@@ -150,6 +156,119 @@ def test_random_dot_inc():
             A.initial_value.dot(X.initial_value), sim.data[probes[0]])
 
 
+@pytest.mark.parametrize("shape", [(40, 3), (2000, 32)])
+def test_shared_encoders(shape):
+    """
+    Test DotIncs that apply the same encoders to several inputs, which are
+    run as a single BatchedDotInc, against the reference implementation.
+    The small encoders fit in one row block and use the small-matrix
+    kernels; the large ones are split into several row blocks.
+    """
+    seed = 1
+    np.random.seed(seed)
+
+    n_neurons, dimensions = shape
+    n_inputs = 4
+
+    encoders = Signal(np.random.random(shape), 'encoders')
+
+    ops = []
+    outputs = []
+    for i in range(n_inputs):
+        X = Signal(np.random.random(dimensions), 'X%d' % i)
+        Y = Signal(np.zeros(n_neurons), 'Y%d' % i)
+
+        ops.extend([Reset(Y), DotInc(encoders, X, Y)])
+        outputs.append(Y)
+
+    probes = [SignalProbe(Y) for Y in outputs]
+
+    with _TestSimulator(ops, probes) as sim:
+        sim.run(0.01)
+
+    model = nengo.builder.Model()
+    for op in ops:
+        model.add_op(op)
+
+    refimpl_sim = nengo.Simulator(None, model=model)
+    refimpl_sim.run(0.01)
+
+    for Y, probe in zip(outputs, probes):
+        assert np.allclose(
+            refimpl_sim.signals[Y], sim.data[probe][-1],
+            atol=0.00001, rtol=0.0)
+
+
+def _check_small_dot_inc(m, n, x_stride, y_stride, sim_options=None):
+    """
+    Run a DotInc of an m x n matrix with a vector, where x and y are views
+    of larger signals with the given strides, and compare with numpy (which
+    uses BLAS). Only y's entries may be changed in y's base signal.
+    """
+    A = Signal(np.random.random((m, n)), 'A')
+    X_base = Signal(np.random.random(n * x_stride), 'X')
+    Y_base = Signal(np.zeros(m * y_stride), 'Y')
+
+    X = X_base[::x_stride]
+    Y = Y_base[::y_stride]
+
+    ops = [Reset(Y_base), DotInc(A, X, Y)]
+    probes = [SignalProbe(Y_base)]
+
+    with _TestSimulator(ops, probes, sim_options=sim_options) as sim:
+        sim.run(0.003)
+
+    ground_truth = np.zeros(m * y_stride)
+    ground_truth[::y_stride] = A.initial_value.dot(X.initial_value)
+
+    for data in sim.data[probes[0]]:
+        assert np.allclose(ground_truth, data)
+
+
+@pytest.mark.parametrize("strides", [(1, 1), (3, 2)])
+@pytest.mark.parametrize("N", range(1, 17))
+def test_small_gemv_few_cols(N, strides):
+    """
+    Test the kernels for matrices with N columns (see small_gemv.hpp),
+    which are used for DotIncs with at most 128 matrix entries.
+    """
+    np.random.seed(N)
+    _check_small_dot_inc(128 // N, N, *strides)
+
+
+@pytest.mark.parametrize("strides", [(1, 1), (3, 2)])
+@pytest.mark.parametrize("M", range(1, 8))
+def test_small_gemv_few_rows(M, strides):
+    """
+    Test the kernels for matrices with M rows and more than 16 columns,
+    which are used for DotIncs with at most 128 matrix entries. The number
+    of columns is not a multiple of 4, so with a contiguous x both the
+    vectorized loop and the remainder loop are run.
+    """
+    np.random.seed(M)
+
+    n = 128 // M
+    n -= int(n % 4 == 0)
+
+    _check_small_dot_inc(M, n, *strides)
+
+
+@pytest.mark.parametrize("strides", [(1, 1), (3, 2)])
+@pytest.mark.parametrize("small_dim", range(1, 17))
+def test_small_gemv_autotune(small_dim, strides):
+    """
+    Test DotIncs with one dimension of at most 16 and more than 128 matrix
+    entries, which only use the small-matrix kernels if autotuning finds
+    them faster than BLAS. Includes the kernels for 8 to 16 rows, which
+    are only chosen by autotuning.
+    """
+    np.random.seed(small_dim)
+
+    sim_options = dict(autotune=True)
+    _check_small_dot_inc(150, small_dim, *strides, sim_options=sim_options)
+    _check_small_dot_inc(small_dim, 150, *strides, sim_options=sim_options)
+
+
 def test_reset():
 
     D = 40
@@ -352,6 +471,63 @@ def test_sliced_copy_seq():
         permuted_thrice, sim.data[probes[0]], atol=0.000001, rtol=0.0)
 
 
+def test_execution_plan():
+    """
+    Test that running operators through the compiled execution plan gives
+    exactly the same results as running them through virtual calls. The
+    operators include a Reset and a Copy of strided views and a scalar
+    DotInc, which the plan also runs through virtual calls.
+    """
+    seed = 1
+    np.random.seed(seed)
+
+    D = 10
+
+    step = Signal(np.array(0, dtype=np.int64), name='step')
+    time = Signal(np.array(0, dtype=np.float64), name='time')
+
+    u = Signal(np.zeros(D), 'u')
+    x = Signal(np.zeros(D), 'x')
+    filtered = Signal(np.zeros(D), 'filtered')
+    x_copy = Signal(np.zeros(D), 'x_copy')
+    reset_base = Signal(np.zeros(2 * D), 'reset_base')
+    copy_base = Signal(np.zeros(2 * D), 'copy_base')
+
+    A = Signal(np.random.random((D, D)) / D, 'A')
+    gain = Signal(np.random.random(D), 'gain')
+    scale = Signal(np.array(0.5), 'scale')
+
+    freqs = np.arange(1, D + 1)
+
+    ops = [
+        TimeUpdate(step, time),
+        SimPyFunc(u, lambda t: np.sin(freqs * t), time, None),
+        Reset(x),
+        DotInc(A, filtered, x),
+        ElementwiseInc(gain, u, x),
+        DotInc(scale, u, x),
+        SimProcess(Lowpass(0.01), x, filtered, t=time),
+        Copy(x, x_copy),
+        Reset(reset_base[::2], 1.0),
+        Copy(filtered, copy_base[1::2])]
+
+    probes = [
+        SignalProbe(s) for s in [x, filtered, x_copy, reset_base, copy_base]]
+
+    data = []
+    for use_plan in [True, False]:
+        sim_options = dict(use_plan=use_plan)
+        with _TestSimulator(ops, probes, sim_options=sim_options) as sim:
+            sim.run(0.1)
+
+        data.append([np.array(sim.data[p]) for p in probes])
+
+    assert np.any(data[0][1] != 0.0)
+
+    for planned, virtual in zip(*data):
+        assert np.array_equal(planned, virtual)
+
+
 def test_lif():
     """Test that the dynamic lif model approximately matches the rates."""
 
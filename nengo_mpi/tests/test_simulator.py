@@ -112,6 +112,191 @@ def test_against_refimpl(Simulator):
         atol=0.00001, rtol=0.0)
 
 
+def test_triangle_synapse(Simulator):
+    """
+    Test that the running-sum TriangleSynapse matches the reference
+    implementation over many wraps of its tap buffer.
+    """
+    sequence = np.random.random((1000, 3))
+
+    def f(t):
+        return sequence[int(t * 1000) % 1000]
+
+    m = nengo.Network(seed=1)
+    with m:
+        input = nengo.Node(f)
+        output = nengo.Node(size_in=3)
+        nengo.Connection(
+            input, output, synapse=nengo.synapses.Triangle(0.05))
+
+        probe = nengo.Probe(output)
+
+    sim_time = 1.0
+
+    refimpl_sim = nengo.Simulator(m)
+    refimpl_sim.run(sim_time)
+
+    mpi_sim = Simulator(m)
+    mpi_sim.run(sim_time)
+
+    assert np.allclose(
+        refimpl_sim.data[probe], mpi_sim.data[probe], atol=0.00001, rtol=0.00)
+
+
+def test_sparse_transform(Simulator):
+    """
+    Test that connections with mostly-zero transforms, which are run as
+    sparse matrix products, match the reference implementation.
+    """
+    d = 20
+    rng = np.random.RandomState(3)
+    transform = np.eye(d)[rng.permutation(d)]
+    transform[0, 1] = 0.5
+
+    m = nengo.Network(seed=1)
+    with m:
+        input = nengo.Node(lambda t: np.sin(t * np.arange(1, d + 1)))
+        output = nengo.Node(size_in=d)
+        nengo.Connection(input, output, transform=transform, synapse=0.01)
+
+        ens = nengo.Ensemble(50, d)
+        nengo.Connection(ens, output, transform=0.01 * np.eye(d))
+
+        probe = nengo.Probe(output)
+
+    sim_time = 0.5
+
+    refimpl_sim = nengo.Simulator(m)
+    refimpl_sim.run(sim_time)
+
+    mpi_sim = Simulator(m)
+    mpi_sim.run(sim_time)
+
+    assert np.allclose(
+        refimpl_sim.data[probe], mpi_sim.data[probe], atol=0.00001, rtol=0.00)
+
+
+def test_stateful_nodes(Simulator):
+    """
+    Test that Nodes whose functions keep state are called once per step and
+    in the same order as by the reference implementation, with operator
+    merging and communication scheduling on (the defaults), when the
+    connection between them is run as a sparse matrix product.
+    """
+    d = 20
+    rng = np.random.RandomState(3)
+    transform = np.eye(d)[rng.permutation(d)]
+    transform[0, 1] = 0.5
+
+    calls = []
+    state = {'source': np.zeros(d), 'sink': np.zeros(d)}
+
+    def source(t):
+        calls.append('source')
+        state['source'] = state['source'] + np.sin(t * np.arange(1, d + 1))
+        return state['source']
+
+    def sink(t, x):
+        calls.append('sink')
+        state['sink'] = 0.9 * state['sink'] + x
+        return state['sink']
+
+    m = nengo.Network(seed=1)
+    with m:
+        input = nengo.Node(source, size_out=d)
+        output = nengo.Node(sink, size_in=d, size_out=d)
+        nengo.Connection(input, output, transform=transform, synapse=None)
+
+        probe = nengo.Probe(output)
+
+    sim_time = 0.5
+
+    def run(sim):
+        del calls[:]
+        state['source'] = np.zeros(d)
+        state['sink'] = np.zeros(d)
+
+        sim.run(sim_time)
+        return list(calls)
+
+    refimpl_sim = nengo.Simulator(m)
+    refimpl_calls = run(refimpl_sim)
+
+    mpi_sim = Simulator(m)
+    mpi_calls = run(mpi_sim)
+
+    assert mpi_calls == refimpl_calls
+    assert np.allclose(
+        refimpl_sim.data[probe], mpi_sim.data[probe], atol=0.00001, rtol=0.00)
+
+
+def test_threads(Simulator):
+    """
+    Test that running each chunk's operators on several threads matches the
+    reference implementation, for a network of Nodes, LIF ensembles and
+    connections between them (DotIncs).
+    """
+    rng = np.random.RandomState(2)
+    sequence = rng.random_sample((1000, 3))
+
+    def f(t):
+        return sequence[int(t * 1000) % 1000]
+
+    m = nengo.Network(seed=1)
+    with m:
+        input = nengo.Node(f)
+        ensembles = [
+            nengo.Ensemble(40, dimensions=3, neuron_type=LIF())
+            for i in range(4)]
+        output = nengo.Node(size_in=3)
+
+        nengo.Connection(input, ensembles[0], synapse=0.01)
+        for pre, post in zip(ensembles[:-1], ensembles[1:]):
+            nengo.Connection(pre, post, synapse=0.005)
+        nengo.Connection(
+            ensembles[0].neurons, ensembles[3].neurons,
+            transform=0.01 * rng.randn(40, 40))
+        nengo.Connection(
+            ensembles[3], output, transform=rng.randn(3, 3), synapse=None)
+
+        probes = [nengo.Probe(e) for e in ensembles] + [nengo.Probe(output)]
+
+    sim_time = 0.2
+
+    refimpl_sim = nengo.Simulator(m)
+    refimpl_sim.run(sim_time)
+
+    mpi_sim = Simulator(m, sim_options=dict(n_threads=4))
+    mpi_sim.run(sim_time)
+
+    for p in probes:
+        assert np.allclose(
+            refimpl_sim.data[p], mpi_sim.data[p], atol=0.00001, rtol=0.00)
+
+
+def test_threads_node_error(Simulator):
+    """
+    Test that an error raised by a Node while the operators are run on
+    several threads is raised by ``run``.
+    """
+    def f(t):
+        if t > 0.05:
+            raise ValueError("Node failed.")
+        return t
+
+    m = nengo.Network(seed=1)
+    with m:
+        input = nengo.Node(f)
+        ens = nengo.Ensemble(40, dimensions=1)
+        nengo.Connection(input, ens)
+        nengo.Probe(ens)
+
+    mpi_sim = Simulator(m, sim_options=dict(n_threads=4))
+
+    with pytest.raises(ValueError):
+        mpi_sim.run(0.1)
+
+
 def test_close_basic():
     network = nengo.Network()
 
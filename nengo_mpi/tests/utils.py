@@ -61,9 +61,11 @@ def run_standalone_mpi(network_file, log_file, n_processors, sim_time):
             pass
 
 
-def run_python_mpi(n_processors, script_name, script_args):
+def run_python_mpi(n_processors, script_name, script_args, nengo_mpi_args=()):
     """ Execute a script in the nengo_mpi context.
 
+    ``nengo_mpi_args`` are passed to nengo_mpi itself (e.g. --hybrid).
+
     Returns: (script output, exit code)
     """
     if isinstance(script_args, str):
@@ -72,7 +74,8 @@ def run_python_mpi(n_processors, script_name, script_args):
     try:
         output = subprocess.check_output([
             'mpirun', '-np', str(n_processors), 'python',
-            '-m', 'nengo_mpi', script_name] + script_args)
+            '-m', 'nengo_mpi'] + list(nengo_mpi_args) +
+            [script_name] + script_args)
         return output.decode('utf-8'), 0
     except subprocess.CalledProcessError as e:
         return e.output.decode('utf-8'), e.returncode